@@ -0,0 +1,150 @@
+#ifndef BASIN_H
+#define BASIN_H
+
+#include "World.h"
+#include "Batch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Describes a grid of starting covers of daisies to run to equilibrium at each of several luminosities, to find which
+ * starting covers lead to which final state where several states are stable
+ */
+struct BasinSettings {
+    bool grayEnabled = false;
+    bool roundWorld = false;
+    std::vector<float> luminosities = {1.0};
+    // how many steps the grid takes from no cover to full cover of each color
+    int resolution = 20;
+    // the longest time in time units to let each run reach equilibrium
+    int maxTime = 500;
+    // a run is at equilibrium once no proportion changes by more than this over a time unit
+    float equilibriumTolerance = 1e-5;
+    // a color survives if it ends with more than this proportion of the planet
+    float survivalThreshold = 0.01;
+};
+
+/**
+ * The final states of the runs started from each cover of the grid, at one luminosity
+ */
+struct BasinMap {
+    /**
+     * The final state of a run, as a bitmask of the colors that survived, so 0 is barren and
+     * (1 << WHITE) | (1 << BLACK) is white and black daisies coexisting
+     */
+    using State = int;
+
+    float luminosity;
+
+    // the starting proportion of each color for each run, and the state it ended in
+    std::vector<std::array<float, World::COLORS>> starts;
+    std::vector<State> states;
+
+    // how long in time units each run took to reach equilibrium, or the maximum time if it did not
+    std::vector<float> times;
+
+    /**
+     * @returns a readable name for a final state, such as "white+black" or "barren"
+     */
+    static std::string StateName(State state) {
+        static const std::string colorNames[World::COLORS] = {"white", "black", "gray"};
+        std::string name;
+        for (int i=0; i<World::COLORS; i++) {
+            if (!(state & (1 << i))) continue;
+            if (!name.empty()) name += "+";
+            name += colorNames[i];
+        }
+        return name.empty() ? "barren" : name;
+    }
+
+    /**
+     * @returns the proportion of starting covers that ended in a state
+     */
+    float Fraction(State state) const {
+        if (states.empty()) return 0.0;
+        int count = 0;
+        for (State s : states) count += s == state;
+        return (float)count / states.size();
+    }
+
+    /**
+     * Writes the map to a csv file with one row per starting cover
+     */
+    void Write(const std::string& fileName) const {
+        std::ofstream file(fileName);
+        file << "a_w,a_b,a_g,state,t" << std::endl;
+        for (size_t i = 0; i < states.size(); i++) {
+            file << starts[i][World::WHITE] << "," << starts[i][World::BLACK] << "," << starts[i][World::GRAY] << "," << states[i] << "," << times[i] << std::endl;
+        }
+    }
+};
+
+/**
+ * Runs a world from one starting cover until it reaches equilibrium, without any seeding, so colors that die out stay
+ * out and colors that start with no cover never appear
+ * @param time Receives how long in time units the run took
+ * @returns the state the run ended in
+ */
+inline BasinMap::State RunToEquilibrium(const BasinSettings& settings, float luminosity, const std::array<float, World::COLORS>& start, float& time) {
+    World world(start[World::WHITE], start[World::BLACK], luminosity, start[World::GRAY], settings.roundWorld);
+    world.SetGrayEnabled(settings.grayEnabled);
+    world.SetSeedingPolicy(SeedingPolicy::WithoutSweepBoosts());
+    int updatesPerTimeUnit = world.GetUpdatesPerTimeUnit();
+    float previous[World::COLORS] = {start[World::WHITE], start[World::BLACK], start[World::GRAY]};
+    int timeUnit;
+    for (timeUnit = 1; timeUnit <= settings.maxTime; timeUnit++) {
+        world.UpdateN(updatesPerTimeUnit);
+        float current[World::COLORS] = {world.GetProportionWhite(), world.GetProportionBlack(), world.GetProportionGray()};
+        float change = 0.0;
+        for (int i=0; i<World::COLORS; i++) {
+            change = std::max(change, std::abs(current[i] - previous[i]));
+            previous[i] = current[i];
+        }
+        if (change < settings.equilibriumTolerance) break;
+    }
+    time = std::min(timeUnit, settings.maxTime);
+    BasinMap::State state = 0;
+    for (int i=0; i<World::COLORS; i++) {
+        if (previous[i] > settings.survivalThreshold) state |= 1 << i;
+    }
+    return state;
+}
+
+/**
+ * Runs every starting cover of the grid to equilibrium at each luminosity, in parallel. The grid covers every
+ * combination of proportions in steps of 1 / resolution that fits on the planet, with gray only when it is enabled.
+ * @returns one map per luminosity
+ */
+inline std::vector<BasinMap> MapBasinsOfAttraction(const BasinSettings& settings) {
+    std::vector<std::array<float, World::COLORS>> starts;
+    int grayResolution = settings.grayEnabled ? settings.resolution : 0;
+    for (int g = 0; g <= grayResolution; g++) {
+        for (int b = 0; b + g <= settings.resolution; b++) {
+            for (int w = 0; w + b + g <= settings.resolution; w++) {
+                float step = 1.0f / settings.resolution;
+                starts.push_back({w * step, b * step, g * step});
+            }
+        }
+    }
+
+    std::vector<BasinMap> maps(settings.luminosities.size());
+    for (size_t l = 0; l < maps.size(); l++) {
+        maps[l].luminosity = settings.luminosities[l];
+        maps[l].starts = starts;
+        maps[l].states.resize(starts.size());
+        maps[l].times.resize(starts.size());
+    }
+    int runsPerMap = starts.size();
+    RunBatch(maps.size() * runsPerMap, [&](int job) {
+        BasinMap& map = maps[job / runsPerMap];
+        int run = job % runsPerMap;
+        map.states[run] = RunToEquilibrium(settings, map.luminosity, starts[run], map.times[run]);
+    });
+    return maps;
+}
+
+#endif
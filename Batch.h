@@ -0,0 +1,70 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+/**
+ * While it exists, makes floating point arithmetic on the current thread flush subnormal results to zero and treat
+ * subnormal inputs as zero (FTZ and DAZ), then restores the previous mode. Subnormals take a slow path through the
+ * processor, so a run where a proportion decays towards 0 can slow down many times over once it gets that small.
+ * Does nothing where the processor has no such mode.
+ */
+class FlushSubnormalsToZero {
+#if defined(__SSE__) || defined(_M_X64)
+    unsigned int previousMode;
+
+    public:
+    FlushSubnormalsToZero() : previousMode(_mm_getcsr()) {
+        // the flush to zero and denormals are zero bits of MXCSR
+        _mm_setcsr(previousMode | 0x8040);
+    }
+
+    ~FlushSubnormalsToZero() {
+        _mm_setcsr(previousMode);
+    }
+#else
+    public:
+    FlushSubnormalsToZero() = default;
+#endif
+
+    FlushSubnormalsToZero(const FlushSubnormalsToZero&) = delete;
+    FlushSubnormalsToZero& operator=(const FlushSubnormalsToZero&) = delete;
+};
+
+/**
+ * Runs a batch of independent jobs across worker threads. Each job is given its index, and jobs are handed out
+ * one at a time so long runs and short runs balance across the workers. Jobs must not share a World.
+ * @param jobCount How many jobs to run
+ * @param job The work to do for each job index, from 0 to jobCount - 1
+ * @param threadCount How many worker threads to use, or 0 to use one per hardware thread
+ * @param flushSubnormals Whether to run the jobs with subnormals flushed to zero, as with FlushSubnormalsToZero
+ */
+inline void RunBatch(int jobCount, const std::function<void(int)>& job, int threadCount = 0, bool flushSubnormals = false) {
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, jobCount);
+    std::atomic<int> nextJob(0);
+    auto runJobs = [&]() {
+        for (int i = nextJob++; i < jobCount; i = nextJob++) job(i);
+    };
+    auto work = [&]() {
+        if (!flushSubnormals) return runJobs();
+        FlushSubnormalsToZero flushing;
+        runJobs();
+    };
+    if (threadCount <= 1) {
+        work();
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t=0; t<threadCount; t++) workers.emplace_back(work);
+    for (std::thread& worker : workers) worker.join();
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef BIFURCATION_H
+#define BIFURCATION_H
+
+#include "Sweep.h"
+#include "Batch.h"
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Describes a scan over luminosity and one other model parameter. Each value of the other parameter gets its own rising
+ * and falling luminosity sweep, where every luminosity continues from the state the last one ended in.
+ */
+struct BifurcationSettings {
+    // the luminosity sweep to run for each value of the parameter
+    SweepSettings sweep;
+    // which of the ModelParameters to scan, such as ModelParameters::DEATH_RATE or ModelParameters::CONDUCTIVITY
+    int parameter = ModelParameters::DEATH_RATE;
+    std::vector<float> parameterValues = {0.1, 0.2, 0.3, 0.4, 0.5};
+    // a color survives where it covers more than this proportion of the planet
+    float survivalThreshold = 0.01;
+    // the temperature is regulated where it changes by less than this many Celsius per unit of luminosity
+    float regulatedSlope = 30.0;
+};
+
+/**
+ * The regime of the world at each luminosity of each sweep of a bifurcation scan
+ */
+struct BifurcationGrid {
+    /**
+     * A regime, as a bitmask of the colors that survive, plus REGULATED if the temperature is regulated
+     */
+    using Regime = int;
+    static constexpr Regime REGULATED = 1 << World::COLORS;
+
+    int parameter;
+    std::vector<float> parameterValues;
+
+    // for each parameter value, the points of its sweep and the regime at each one
+    std::vector<std::vector<SweepPoint<float>>> points;
+    std::vector<std::vector<Regime>> regimes;
+
+    /**
+     * @returns a readable name for a regime, such as "white+black regulated" or "barren"
+     */
+    static std::string RegimeName(Regime regime) {
+        static const std::string colorNames[World::COLORS] = {"white", "black", "gray"};
+        std::string name;
+        for (int i=0; i<World::COLORS; i++) {
+            if (!(regime & (1 << i))) continue;
+            if (!name.empty()) name += "+";
+            name += colorNames[i];
+        }
+        if (name.empty()) name = "barren";
+        return regime & REGULATED ? name + " regulated" : name;
+    }
+
+    /**
+     * Writes the grid to a csv file with one row per luminosity of each sweep
+     */
+    void Write(const std::string& fileName) const {
+        std::ofstream file(fileName);
+        file << ModelParameters::Name(parameter) << ",L,rising,a_w,a_b,a_g,temp,regime" << std::endl;
+        for (size_t i = 0; i < parameterValues.size(); i++) {
+            for (size_t j = 0; j < points[i].size(); j++) {
+                const SweepPoint<float>& point = points[i][j];
+                file << parameterValues[i] << "," << point.luminosity << "," << point.rising << "," << point.proportion[World::WHITE] << "," << point.proportion[World::BLACK] << "," << point.proportion[World::GRAY] << "," << point.temperature << "," << regimes[i][j] << std::endl;
+            }
+        }
+    }
+};
+
+/**
+ * Scans luminosity against another model parameter, running the sweeps for the different parameter values in parallel,
+ * and classifies the regime at every point by which colors survive and whether the temperature is regulated
+ * @returns the regime-classified grid
+ */
+inline BifurcationGrid RunBifurcationScan(const BifurcationSettings& settings) {
+    BifurcationGrid grid;
+    grid.parameter = settings.parameter;
+    grid.parameterValues = settings.parameterValues;
+    int lines = settings.parameterValues.size();
+    grid.points.resize(lines);
+    grid.regimes.resize(lines);
+    RunBatch(lines, [&](int line) {
+        ModelParameters parameters;
+        parameters.values[settings.parameter] = settings.parameterValues[line];
+        std::vector<SweepPoint<float>>& points = grid.points[line];
+        points = RunLuminositySweep<float>(settings.sweep, [&](World& world) { parameters.ApplyTo(world); });
+        std::vector<BifurcationGrid::Regime>& regimes = grid.regimes[line];
+        regimes.resize(points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            BifurcationGrid::Regime regime = 0;
+            for (int color = 0; color < World::COLORS; color++) {
+                if (points[i].proportion[color] > settings.survivalThreshold) regime |= 1 << color;
+            }
+            // the slope of the temperature to the neighboring point of the same part of the sweep
+            size_t neighbor = i > 0 && points[i - 1].rising == points[i].rising ? i - 1 : i + 1;
+            if (regime != 0 && neighbor < points.size() && points[neighbor].rising == points[i].rising) {
+                float slope = std::abs((points[i].temperature - points[neighbor].temperature) / (points[i].luminosity - points[neighbor].luminosity));
+                if (slope < settings.regulatedSlope) regime |= BifurcationGrid::REGULATED;
+            }
+            regimes[i] = regime;
+        }
+    });
+    return grid;
+}
+
+#endif
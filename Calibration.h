@@ -0,0 +1,404 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "Batch.h"
+#include "Dual.h"
+#include "Sweep.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Target data that a luminosity sweep should reproduce, such as one of the csv files in data/ written by the tests
+ * or values read off the graphs of the Daisyworld paper
+ */
+struct CalibrationTarget {
+    /**
+     * One luminosity of the target curve
+     */
+    struct Row {
+        float luminosity;
+        bool rising;
+        // one value per column being fit, NaN where the cell is empty
+        std::vector<float> values;
+    };
+
+    /**
+     * Which data file columns are fit, such as "a_w", "a_b", "a_g", or "temp"
+     */
+    std::vector<std::string> columns;
+
+    /**
+     * How much each column counts towards the loss. Temperatures are in degrees while proportions are below 1,
+     * so temperature usually needs a smaller weight.
+     */
+    std::vector<float> weights;
+
+    std::vector<Row> rows;
+
+    /**
+     * Reads a target curve from a data file in the format written by World::SetupDataFile. Rows are assigned to the
+     * rising or falling part of the sweep by whether they come before the highest luminosity. Empty cells are left out
+     * of the fit.
+     * @param fileName The csv file to read
+     * @param _columns Which columns to fit
+     * @param _weights How much each column counts towards the loss
+     * @throws std::runtime_error if the file can't be read, lacks the t or L column or a fitted column, or has a cell
+     * that is not a number
+     */
+    static CalibrationTarget LoadFromFile(const std::string& fileName, const std::vector<std::string>& _columns, const std::vector<float>& _weights) {
+        CalibrationTarget target;
+        target.columns = _columns;
+        target.weights = _weights;
+        std::ifstream file(fileName);
+        std::string line;
+        if (!std::getline(file, line)) throw std::runtime_error("Can't read calibration target " + fileName);
+        std::vector<std::string> header = SplitLine(line);
+        auto findColumn = [&](const std::string& column) {
+            int index = std::find(header.begin(), header.end(), column) - header.begin();
+            if (index == (int)header.size()) throw std::runtime_error("Calibration target " + fileName + " has no " + column + " column");
+            return index;
+        };
+        int timeIndex = findColumn("t");
+        int luminosityIndex = findColumn("L");
+        std::vector<int> columnIndexes;
+        for (const std::string& column : _columns) columnIndexes.push_back(findColumn(column));
+        float maxLuminosity = -std::numeric_limits<float>::infinity();
+        while (std::getline(file, line)) {
+            std::vector<std::string> cells = SplitLine(line);
+            // the first row of a data file is the starting state, before the world stabilized
+            if (timeIndex < (int)cells.size() && cells[timeIndex] == "0") continue;
+            Row row;
+            if (luminosityIndex >= (int)cells.size() || cells[luminosityIndex].empty()) continue;
+            row.luminosity = ParseCell(cells[luminosityIndex], fileName);
+            for (int index : columnIndexes) {
+                row.values.push_back(index < (int)cells.size() && !cells[index].empty() ? ParseCell(cells[index], fileName) : std::numeric_limits<float>::quiet_NaN());
+            }
+            maxLuminosity = std::max(maxLuminosity, row.luminosity);
+            target.rows.push_back(row);
+        }
+        // everything up to the first row at the highest luminosity is on the rising part of the sweep
+        bool rising = true;
+        for (Row& row : target.rows) {
+            if (row.luminosity == maxLuminosity) rising = false;
+            row.rising = rising;
+        }
+        return target;
+    }
+
+    /**
+     * Calculates the weighted residuals between a simulated sweep and this target, pairing each simulated point with the
+     * target row on the same part of the sweep at the same luminosity. Simulated points with no matching row, and
+     * columns left empty in the matching row, are skipped.
+     * @returns one residual per matched point and column, so that the loss is the sum of their squares
+     */
+    template <typename Scalar>
+    std::vector<Scalar> Residuals(const std::vector<SweepPoint<Scalar>>& points) const {
+        // index the target rows by luminosity, to the nearest ten thousandth
+        std::map<long, const Row*> risingRows, fallingRows;
+        for (const Row& row : rows) {
+            (row.rising ? risingRows : fallingRows)[std::lround(row.luminosity * 10000)] = &row;
+        }
+        std::vector<Scalar> residuals;
+        for (const SweepPoint<Scalar>& point : points) {
+            const std::map<long, const Row*>& rowsOnBranch = point.rising ? risingRows : fallingRows;
+            auto match = rowsOnBranch.find(std::lround(point.luminosity * 10000));
+            if (match == rowsOnBranch.end()) continue;
+            for (size_t i=0; i<columns.size(); i++) {
+                if (std::isnan(match->second->values[i])) continue;
+                residuals.push_back(std::sqrt(weights[i]) * (point.Column(columns[i]) - match->second->values[i]));
+            }
+        }
+        return residuals;
+    }
+
+    private:
+
+    /**
+     * Splits a line of a csv file into its cells
+     */
+    static std::vector<std::string> SplitLine(const std::string& line) {
+        std::vector<std::string> cells;
+        std::stringstream stream(line);
+        std::string cell;
+        while (std::getline(stream, cell, ',')) cells.push_back(cell);
+        return cells;
+    }
+
+    /**
+     * @returns the number in a cell of a csv file
+     * @throws std::runtime_error if the cell is not a number
+     */
+    static float ParseCell(const std::string& cell, const std::string& fileName) {
+        try {
+            return std::stof(cell);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Calibration target " + fileName + " has a cell that is not a number: " + cell);
+        }
+    }
+};
+
+/**
+ * The outcome of fitting model parameters to a target
+ */
+struct CalibrationResult {
+    ModelParameters parameters;
+    // the sum of squared weighted residuals at the fitted parameters
+    float loss;
+    // how many sweeps were simulated to find the fit
+    int evaluations;
+};
+
+/**
+ * Fits some of the model parameters so that a luminosity sweep reproduces target data. Each candidate set of
+ * parameters is evaluated by simulating the whole sweep, and candidates are evaluated in parallel with RunBatch.
+ */
+class Calibrator {
+    SweepSettings settings;
+    CalibrationTarget target;
+
+    // which ModelParameters are being fit
+    std::vector<int> fittedParameters;
+
+    // the values of the parameters that are not being fit, and the starting values of those that are
+    ModelParameters initialParameters;
+
+    // how many sweeps have been simulated
+    int evaluations = 0;
+
+    /**
+     * @returns the model parameters with the fitted parameters replaced by x, clamped to their physical range
+     */
+    ModelParameters ToParameters(const std::vector<float>& x) const {
+        ModelParameters parameters = initialParameters;
+        for (size_t i=0; i<fittedParameters.size(); i++) {
+            int parameter = fittedParameters[i];
+            parameters.values[parameter] = std::clamp(x[i], ModelParameters::LowerBound(parameter), ModelParameters::UpperBound(parameter));
+        }
+        return parameters;
+    }
+
+    /**
+     * @returns the values of the fitted parameters
+     */
+    std::vector<float> FromParameters(const ModelParameters& parameters) const {
+        std::vector<float> x;
+        for (int parameter : fittedParameters) x.push_back(parameters.values[parameter]);
+        return x;
+    }
+
+    /**
+     * Simulates a sweep with these values of the fitted parameters
+     * @returns the sum of squared weighted residuals against the target
+     */
+    float Loss(const std::vector<float>& x) const {
+        ModelParameters parameters = ToParameters(x);
+        std::vector<SweepPoint<float>> points = RunLuminositySweep<float>(settings, [&parameters](World& world) { parameters.ApplyTo(world); });
+        float loss = 0.0;
+        for (float residual : target.Residuals(points)) loss += residual * residual;
+        return loss;
+    }
+
+    /**
+     * Evaluates the loss of several candidates in parallel
+     */
+    std::vector<float> Losses(const std::vector<std::vector<float>>& candidates) {
+        std::vector<float> losses(candidates.size());
+        RunBatch(candidates.size(), [&](int i) { losses[i] = Loss(candidates[i]); }, threadCount);
+        evaluations += candidates.size();
+        return losses;
+    }
+
+    /**
+     * Solves the linear system A x = b by Gaussian elimination with partial pivoting
+     * @param A A square matrix, stored by rows
+     */
+    static std::vector<float> Solve(std::vector<std::vector<float>> A, std::vector<float> b) {
+        int n = b.size();
+        for (int column = 0; column < n; column++) {
+            int pivot = column;
+            for (int row = column + 1; row < n; row++) {
+                if (std::abs(A[row][column]) > std::abs(A[pivot][column])) pivot = row;
+            }
+            std::swap(A[column], A[pivot]);
+            std::swap(b[column], b[pivot]);
+            if (A[column][column] == 0.0f) continue;
+            for (int row = column + 1; row < n; row++) {
+                float factor = A[row][column] / A[column][column];
+                for (int k = column; k < n; k++) A[row][k] -= factor * A[column][k];
+                b[row] -= factor * b[column];
+            }
+        }
+        std::vector<float> x(n, 0.0f);
+        for (int row = n - 1; row >= 0; row--) {
+            float total = b[row];
+            for (int k = row + 1; k < n; k++) total -= A[row][k] * x[k];
+            x[row] = A[row][row] == 0.0f ? 0.0f : total / A[row][row];
+        }
+        return x;
+    }
+
+    public:
+
+    /**
+     * How many threads candidate evaluations use, or 0 for one per hardware thread
+     */
+    int threadCount = 0;
+
+    /**
+     * @param _settings The sweep to simulate for each candidate. Coarser and shorter sweeps than the tests use are
+     * usually accurate enough and much faster.
+     * @param _target The data to fit
+     * @param _fittedParameters Which ModelParameters to fit
+     * @param _initialParameters Starting values for the fitted parameters and fixed values for the others
+     */
+    Calibrator(const SweepSettings& _settings, const CalibrationTarget& _target, const std::vector<int>& _fittedParameters, const ModelParameters& _initialParameters = ModelParameters())
+        : settings(_settings), target(_target), fittedParameters(_fittedParameters), initialParameters(_initialParameters) {}
+
+    /**
+     * Fits the parameters with the Levenberg-Marquardt method. The Jacobian of the residuals is computed in a single sweep
+     * with Dual numbers, then several damping factors are tried in parallel and the best one is kept.
+     * @param maxIterations The most Jacobians to compute
+     * @param tolerance Stop when the loss improves by less than this fraction
+     */
+    CalibrationResult LevenbergMarquardt(int maxIterations = 20, float tolerance = 0.0001) {
+        using Scalar = Dual<ModelParameters::COUNT>;
+        int n = fittedParameters.size();
+        std::vector<float> x = FromParameters(initialParameters);
+        float loss = Losses({x})[0];
+        float damping = 0.001;
+        for (int iteration = 0; iteration < maxIterations; iteration++) {
+            // simulate with the fitted parameters seeded so the residuals carry their derivatives
+            ModelParameters parameters = ToParameters(x);
+            std::vector<SweepPoint<Scalar>> points = RunLuminositySweep<Scalar>(settings, [&](DaisyWorld<Scalar>& world) {
+                parameters.ApplyTo(world);
+                for (int i=0; i<n; i++) ModelParameters::Set(world, fittedParameters[i], Scalar::Parameter(x[i], i));
+            });
+            evaluations++;
+            std::vector<Scalar> residuals = target.Residuals(points);
+
+            // normal equations J^T J and J^T r
+            std::vector<std::vector<float>> JTJ(n, std::vector<float>(n, 0.0f));
+            std::vector<float> JTr(n, 0.0f);
+            for (const Scalar& residual : residuals) {
+                for (int i=0; i<n; i++) {
+                    JTr[i] += residual.Derivative(i) * residual.value;
+                    for (int j=0; j<n; j++) JTJ[i][j] += residual.Derivative(i) * residual.Derivative(j);
+                }
+            }
+
+            // try a smaller, the same, and a larger damping factor at once
+            const float dampingFactors[3] = {0.1, 1.0, 10.0};
+            std::vector<std::vector<float>> candidates;
+            for (float factor : dampingFactors) {
+                std::vector<std::vector<float>> A = JTJ;
+                std::vector<float> b(n);
+                for (int i=0; i<n; i++) {
+                    A[i][i] += damping * factor * (JTJ[i][i] > 0.0f ? JTJ[i][i] : 1.0f);
+                    b[i] = -JTr[i];
+                }
+                std::vector<float> step = Solve(A, b);
+                std::vector<float> candidate = x;
+                for (int i=0; i<n; i++) candidate[i] += step[i];
+                candidates.push_back(FromParameters(ToParameters(candidate)));
+            }
+            std::vector<float> losses = Losses(candidates);
+            int best = std::min_element(losses.begin(), losses.end()) - losses.begin();
+            if (losses[best] < loss) {
+                // stop once the fit stops improving, or is exact to float precision
+                bool converged = loss - losses[best] < tolerance * loss || losses[best] < tolerance * tolerance;
+                x = candidates[best];
+                loss = losses[best];
+                damping *= dampingFactors[best];
+                if (converged) break;
+            } else {
+                // no candidate improved, so take smaller steps
+                damping *= 100.0;
+            }
+        }
+        return {ToParameters(x), loss, evaluations};
+    }
+
+    /**
+     * Fits the parameters with the Nelder-Mead simplex method, which needs no derivatives. Each iteration evaluates the
+     * reflected, expanded, and both contracted points in parallel, rather than one after another.
+     * @param maxIterations The most simplex iterations to do
+     * @param initialStep The size of the starting simplex, as a fraction of each starting parameter value
+     * @param tolerance Stop when the losses of the simplex vertices differ by less than this
+     */
+    CalibrationResult NelderMead(int maxIterations = 100, float initialStep = 0.1, float tolerance = 0.00001) {
+        int n = fittedParameters.size();
+        std::vector<std::vector<float>> simplex(n + 1, FromParameters(initialParameters));
+        for (int i=0; i<n; i++) {
+            simplex[i + 1][i] += initialStep * (simplex[i + 1][i] != 0.0f ? simplex[i + 1][i] : 1.0f);
+        }
+        std::vector<float> losses = Losses(simplex);
+
+        for (int iteration = 0; iteration < maxIterations; iteration++) {
+            // sort vertices from best to worst
+            std::vector<int> order(n + 1);
+            for (int i=0; i<=n; i++) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return losses[a] < losses[b]; });
+            std::vector<std::vector<float>> sortedSimplex;
+            std::vector<float> sortedLosses;
+            for (int i : order) {
+                sortedSimplex.push_back(simplex[i]);
+                sortedLosses.push_back(losses[i]);
+            }
+            simplex = sortedSimplex;
+            losses = sortedLosses;
+            if (losses[n] - losses[0] < tolerance) break;
+
+            // centroid of every vertex except the worst
+            std::vector<float> centroid(n, 0.0f);
+            for (int i=0; i<n; i++) {
+                for (int j=0; j<n; j++) centroid[j] += simplex[i][j] / n;
+            }
+            // reflection, expansion, outside contraction, and inside contraction of the worst vertex through the centroid
+            const float coefficients[4] = {1.0, 2.0, 0.5, -0.5};
+            std::vector<std::vector<float>> candidates;
+            for (float coefficient : coefficients) {
+                std::vector<float> candidate(n);
+                for (int j=0; j<n; j++) candidate[j] = centroid[j] + coefficient * (centroid[j] - simplex[n][j]);
+                candidates.push_back(FromParameters(ToParameters(candidate)));
+            }
+            std::vector<float> candidateLosses = Losses(candidates);
+            float reflected = candidateLosses[0], expanded = candidateLosses[1], outside = candidateLosses[2], inside = candidateLosses[3];
+
+            int accepted = -1;
+            if (reflected < losses[0]) {
+                accepted = expanded < reflected ? 1 : 0;
+            } else if (reflected < losses[n - 1]) {
+                accepted = 0;
+            } else if (reflected < losses[n]) {
+                if (outside <= reflected) accepted = 2;
+            } else if (inside < losses[n]) {
+                accepted = 3;
+            }
+
+            if (accepted >= 0) {
+                simplex[n] = candidates[accepted];
+                losses[n] = candidateLosses[accepted];
+            } else {
+                // shrink every vertex towards the best one
+                std::vector<std::vector<float>> shrunk;
+                for (int i=1; i<=n; i++) {
+                    for (int j=0; j<n; j++) simplex[i][j] = simplex[0][j] + 0.5f * (simplex[i][j] - simplex[0][j]);
+                    shrunk.push_back(simplex[i]);
+                }
+                std::vector<float> shrunkLosses = Losses(shrunk);
+                for (int i=1; i<=n; i++) losses[i] = shrunkLosses[i - 1];
+            }
+        }
+        int best = std::min_element(losses.begin(), losses.end()) - losses.begin();
+        return {ToParameters(simplex[best]), losses[best], evaluations};
+    }
+};
+
+#endif
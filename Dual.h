@@ -0,0 +1,145 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+/**
+ * A forward-mode automatic differentiation number. Alongside its value it carries the partial derivatives of that
+ * value with respect to N seeded parameters, so running the world on Dual numbers yields both the results of a
+ * simulation and their gradients in a single run.
+ * @tparam N The number of parameters being differentiated with respect to
+ */
+template <int N>
+struct Dual {
+    /**
+     * The value of this number
+     */
+    float value;
+
+    /**
+     * gradient[i] is the partial derivative of value with respect to parameter i
+     */
+    float gradient[N] = {};
+
+    /**
+     * Creates a constant, whose derivative with respect to every parameter is 0
+     */
+    Dual(float _value = 0.0f) : value(_value) {}
+
+    /**
+     * Creates a seeded parameter, whose derivative with respect to itself is 1
+     * @param _value The value of the parameter
+     * @param index Which of the N parameters this is
+     */
+    static Dual Parameter(float _value, int index) {
+        Dual parameter(_value);
+        parameter.gradient[index] = 1.0f;
+        return parameter;
+    }
+
+    /**
+     * @returns the partial derivative of this number with respect to parameter index
+     */
+    float Derivative(int index) const {
+        return gradient[index];
+    }
+
+    Dual& operator+=(const Dual& other) {
+        value += other.value;
+        for (int i=0; i<N; i++) gradient[i] += other.gradient[i];
+        return *this;
+    }
+
+    Dual& operator-=(const Dual& other) {
+        value -= other.value;
+        for (int i=0; i<N; i++) gradient[i] -= other.gradient[i];
+        return *this;
+    }
+
+    Dual& operator*=(const Dual& other) {
+        // product rule
+        for (int i=0; i<N; i++) gradient[i] = gradient[i] * other.value + value * other.gradient[i];
+        value *= other.value;
+        return *this;
+    }
+
+    Dual& operator/=(const Dual& other) {
+        // quotient rule
+        for (int i=0; i<N; i++) gradient[i] = (gradient[i] * other.value - value * other.gradient[i]) / (other.value * other.value);
+        value /= other.value;
+        return *this;
+    }
+
+    Dual operator-() const {
+        Dual negated(-value);
+        for (int i=0; i<N; i++) negated.gradient[i] = -gradient[i];
+        return negated;
+    }
+};
+
+template <int N> Dual<N> operator+(Dual<N> a, const Dual<N>& b) { return a += b; }
+template <int N> Dual<N> operator+(Dual<N> a, float b) { return a += Dual<N>(b); }
+template <int N> Dual<N> operator+(float a, const Dual<N>& b) { return Dual<N>(a) += b; }
+
+template <int N> Dual<N> operator-(Dual<N> a, const Dual<N>& b) { return a -= b; }
+template <int N> Dual<N> operator-(Dual<N> a, float b) { return a -= Dual<N>(b); }
+template <int N> Dual<N> operator-(float a, const Dual<N>& b) { return Dual<N>(a) -= b; }
+
+template <int N> Dual<N> operator*(Dual<N> a, const Dual<N>& b) { return a *= b; }
+template <int N> Dual<N> operator*(Dual<N> a, float b) { return a *= Dual<N>(b); }
+template <int N> Dual<N> operator*(float a, const Dual<N>& b) { return Dual<N>(a) *= b; }
+
+template <int N> Dual<N> operator/(Dual<N> a, const Dual<N>& b) { return a /= b; }
+template <int N> Dual<N> operator/(Dual<N> a, float b) { return a /= Dual<N>(b); }
+template <int N> Dual<N> operator/(float a, const Dual<N>& b) { return Dual<N>(a) /= b; }
+
+// comparisons only look at the value, so branches in the model follow the same path as a float run would
+template <int N> bool operator<(const Dual<N>& a, const Dual<N>& b) { return a.value < b.value; }
+template <int N> bool operator<(const Dual<N>& a, float b) { return a.value < b; }
+template <int N> bool operator<(float a, const Dual<N>& b) { return a < b.value; }
+template <int N> bool operator>(const Dual<N>& a, const Dual<N>& b) { return a.value > b.value; }
+template <int N> bool operator>(const Dual<N>& a, float b) { return a.value > b; }
+template <int N> bool operator>(float a, const Dual<N>& b) { return a > b.value; }
+template <int N> bool operator<=(const Dual<N>& a, float b) { return a.value <= b; }
+template <int N> bool operator>=(const Dual<N>& a, float b) { return a.value >= b; }
+
+/**
+ * Raises a dual number to a constant power, for the Stefan-Boltzmann fourth root
+ */
+template <int N>
+Dual<N> pow(const Dual<N>& base, float exponent) {
+    Dual<N> result(std::pow(base.value, exponent));
+    // d/dx x^p = p * x^(p-1)
+    float outerDerivative = exponent * std::pow(base.value, exponent - 1.0f);
+    for (int i=0; i<N; i++) result.gradient[i] = outerDerivative * base.gradient[i];
+    return result;
+}
+
+/**
+ * Takes the square root of a dual number
+ */
+template <int N>
+Dual<N> sqrt(const Dual<N>& x) {
+    Dual<N> result(std::sqrt(x.value));
+    // d/dx sqrt(x) = 1 / (2 sqrt(x))
+    float outerDerivative = 0.5f / result.value;
+    for (int i=0; i<N; i++) result.gradient[i] = outerDerivative * x.gradient[i];
+    return result;
+}
+
+/**
+ * @returns the plain value of a model quantity, for output and for decisions that should not depend on derivatives
+ */
+inline float ScalarValue(float x) {
+    return x;
+}
+
+/**
+ * @returns the value part of a dual number, dropping its derivatives
+ */
+template <int N>
+float ScalarValue(const Dual<N>& x) {
+    return x.value;
+}
+
+#endif
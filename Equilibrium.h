@@ -0,0 +1,182 @@
+#ifndef EQUILIBRIUM_H
+#define EQUILIBRIUM_H
+
+#include "World.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+/**
+ * Describes how to relax a world to equilibrium. Running some updates of the world is treated as a map from the
+ * proportions at the start to the proportions at the end, and equilibrium is a fixed point of that map.
+ */
+struct EquilibriumSettings {
+    // how many updates make up one application of the map
+    int updatesPerIteration = 100;
+    // the most times to apply the map
+    int maxIterations = 2000;
+    // the world is at equilibrium once no proportion changes by more than this over one application of the map
+    double tolerance = 1e-6;
+    // whether to extrapolate from past applications of the map with Anderson acceleration, rather than just applying it
+    // over and over, which is the same as running the world
+    bool accelerate = true;
+    // how many past applications of the map Anderson acceleration fits the next proportions to
+    int historySize = 5;
+};
+
+/**
+ * How relaxing a world to equilibrium went
+ */
+struct EquilibriumResult {
+    bool converged = false;
+    // how many times the map was applied, and how many updates that took
+    int iterations = 0;
+    long updates = 0;
+    // the largest change of a proportion over the last application of the map
+    double residual = 0.0;
+};
+
+/**
+ * Relaxes proportions to a fixed point of a map, such as running a world for some updates. With acceleration, each
+ * next guess mixes the last few results of the map with the weights that best cancel their changes (Anderson
+ * acceleration), then is clipped so every proportion stays positive and the colors at each latitude cover at most the
+ * whole latitude. Colors the map has killed off stay dead.
+ * @param cover The proportions of each color at each latitude, ordered by latitude and then color. Receives the last
+ * result of the map.
+ * @param colorsPerLatitude How many proportions each latitude has
+ * @param map Replaces the proportions it is given with the result of running settings.updatesPerIteration updates
+ * from them
+ */
+template <typename Map>
+EquilibriumResult RelaxFixedPoint(std::vector<double>& cover, int colorsPerLatitude, Map map, const EquilibriumSettings& settings) {
+    EquilibriumResult result;
+    std::vector<double>& x = cover;
+    int n = x.size();
+    if (n == 0) return result;
+
+    // the changes of the results of the map and of their residuals between consecutive applications, newest last
+    std::deque<std::vector<double>> resultChanges, residualChanges;
+    std::vector<double> previousResult, previousResidual;
+    double previousNorm = 0.0;
+    for (result.iterations = 1; result.iterations <= settings.maxIterations; result.iterations++) {
+        std::vector<double> mapped = x;
+        map(mapped);
+        result.updates += settings.updatesPerIteration;
+        std::vector<double> residual(n);
+        result.residual = 0.0;
+        for (int i = 0; i < n; i++) {
+            residual[i] = mapped[i] - x[i];
+            result.residual = std::max(result.residual, std::abs(residual[i]));
+        }
+        // the mapped proportions are the best estimate
+        if (result.residual < settings.tolerance) {
+            result.converged = true;
+            x = mapped;
+            return result;
+        }
+        if (!settings.accelerate || settings.historySize <= 0) {
+            x = mapped;
+            continue;
+        }
+
+        double norm = 0.0;
+        for (double r : residual) norm += r * r;
+        if (!previousResult.empty() && norm > previousNorm) {
+            // the extrapolation made things worse, so start the history over from here
+            resultChanges.clear();
+            residualChanges.clear();
+        } else if (!previousResult.empty()) {
+            std::vector<double> resultChange(n), residualChange(n);
+            for (int i = 0; i < n; i++) {
+                resultChange[i] = mapped[i] - previousResult[i];
+                residualChange[i] = residual[i] - previousResidual[i];
+            }
+            resultChanges.push_back(resultChange);
+            residualChanges.push_back(residualChange);
+            if ((int)resultChanges.size() > settings.historySize) {
+                resultChanges.pop_front();
+                residualChanges.pop_front();
+            }
+        }
+        previousResult = mapped;
+        previousResidual = residual;
+        previousNorm = norm;
+
+        // find the weights that best cancel the residual, min |residual - residualChanges * weights|, by a QR
+        // factorization of the residual changes with modified Gram-Schmidt. Changes that are nearly combinations of
+        // the ones before them are left out.
+        int m = residualChanges.size();
+        std::vector<std::vector<double>> q;
+        std::vector<std::vector<double>> r(m, std::vector<double>(m, 0.0));
+        std::vector<int> kept;
+        for (int j = 0; j < m; j++) {
+            std::vector<double> v = residualChanges[j];
+            double original = 0.0;
+            for (double value : v) original += value * value;
+            for (size_t k = 0; k < q.size(); k++) {
+                double dot = 0.0;
+                for (int i = 0; i < n; i++) dot += q[k][i] * v[i];
+                r[k][j] = dot;
+                for (int i = 0; i < n; i++) v[i] -= dot * q[k][i];
+            }
+            double length = 0.0;
+            for (double value : v) length += value * value;
+            if (length <= 1e-20 * original || length == 0.0) continue;
+            length = std::sqrt(length);
+            for (double& value : v) value /= length;
+            r[q.size()][j] = length;
+            q.push_back(v);
+            kept.push_back(j);
+        }
+        int rank = q.size();
+        std::vector<double> weights(rank, 0.0);
+        for (int k = 0; k < rank; k++) {
+            for (int i = 0; i < n; i++) weights[k] += q[k][i] * residual[i];
+        }
+        // back substitution through the kept columns of r
+        for (int k = rank - 1; k >= 0; k--) {
+            for (int l = k + 1; l < rank; l++) weights[k] -= r[k][kept[l]] * weights[l];
+            weights[k] /= r[k][kept[k]];
+        }
+
+        std::vector<double> next = mapped;
+        for (int k = 0; k < rank; k++) {
+            for (int i = 0; i < n; i++) next[i] -= weights[k] * resultChanges[kept[k]][i];
+        }
+        // keep each latitude inside the simplex, without reviving colors that have died
+        for (int latitude = 0; latitude < n / colorsPerLatitude; latitude++) {
+            double total = 0.0;
+            for (int a = 0; a < colorsPerLatitude; a++) {
+                int i = latitude * colorsPerLatitude + a;
+                next[i] = mapped[i] > 0.0 ? std::max(next[i], 0.0) : 0.0;
+                total += next[i];
+            }
+            if (total > 1.0) {
+                for (int a = 0; a < colorsPerLatitude; a++) next[latitude * colorsPerLatitude + a] /= total;
+            }
+        }
+        x = next;
+    }
+    result.iterations = settings.maxIterations;
+    return result;
+}
+
+/**
+ * Relaxes a world to equilibrium with RelaxFixedPoint, leaving it in the equilibrium state. The world should not seed
+ * daisies as it runs, such as with SeedingPolicy::WithoutSweepBoosts(), or running it has no fixed point.
+ */
+inline EquilibriumResult RelaxToEquilibrium(World& world, const EquilibriumSettings& settings = EquilibriumSettings()) {
+    int colors = 0;
+    for (int i=0; i<World::COLORS; i++) colors += world.IsColorEnabled(i);
+    std::vector<double> cover = world.GetCoverVector();
+    EquilibriumResult result = RelaxFixedPoint(cover, colors, [&](std::vector<double>& proportions) {
+        world.SetCoverVector(proportions);
+        world.UpdateN(settings.updatesPerIteration);
+        proportions = world.GetCoverVector();
+    }, settings);
+    world.SetCoverVector(cover);
+    return result;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "World.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Something notable that happened to the world at a precise moment, found between two updates
+ */
+struct WorldEvent {
+    enum Type { EXTINCTION, RECOVERY, LEFT_HABITABLE_BAND, ENTERED_HABITABLE_BAND };
+    Type type;
+    // the color of daisy for extinctions and recoveries, otherwise -1
+    int color;
+    // the time in time units and the solar luminosity at which the threshold was crossed
+    float time;
+    float luminosity;
+
+    /**
+     * @returns the name of this type of event, for the event log
+     */
+    std::string Name() const {
+        static const std::string names[4] = {"extinction", "recovery", "left_habitable_band", "entered_habitable_band"};
+        return names[type];
+    }
+};
+
+/**
+ * Watches a world as it updates and detects when the daisies go extinct or recover, and when the global temperature
+ * leaves or re-enters the band where daisies can grow. An Euler step moves the proportions of daisies, and therefore
+ * the albedo, linearly in time, so the moment within the step that a threshold is crossed is found by root-finding
+ * along that line.
+ *
+ * On a flat world, a color goes extinct when it falls below the world's extinction threshold, timed along the step as
+ * it was before the world cleared the color. On a round world, the global proportion is an average that falls below
+ * the threshold while latitudes are still alive, so a color only goes extinct once it is gone from every latitude, at
+ * the end of the step that cleared the last of it.
+ */
+class EventDetector {
+    /**
+     * The parts of the world's state that events are detected on
+     */
+    struct Snapshot {
+        float time;
+        float luminosity;
+        float albedo;
+        float temperature;
+        float proportion[World::COLORS];
+    };
+
+    Snapshot previous;
+    bool hasPrevious = false;
+
+    // whether each color is currently considered extinct, and whether the temperature is in the habitable band
+    bool extinct[World::COLORS] = {};
+    bool habitable = true;
+
+    std::vector<WorldEvent> events;
+
+    template <typename Scalar>
+    Snapshot TakeSnapshot(DaisyWorld<Scalar>& world) {
+        Snapshot snapshot;
+        snapshot.time = world.GetTime();
+        snapshot.luminosity = ScalarValue(world.GetSolarLuminosity());
+        snapshot.albedo = ScalarValue(world.GetTotalAlbedo());
+        snapshot.temperature = ScalarValue(world.GetGlobalTemperature());
+        snapshot.proportion[World::WHITE] = ScalarValue(world.GetProportionWhite());
+        snapshot.proportion[World::BLACK] = ScalarValue(world.GetProportionBlack());
+        snapshot.proportion[World::GRAY] = ScalarValue(world.GetProportionGray());
+        return snapshot;
+    }
+
+    /**
+     * Records an event that happened a fraction of the way from the previous snapshot to the current one. The luminosity
+     * is set before a step and held through it, so the event happened at the current luminosity.
+     */
+    void Record(WorldEvent::Type type, int color, float fraction, const Snapshot& current) {
+        float time = previous.time + fraction * (current.time - previous.time);
+        events.push_back({type, color, time, current.luminosity});
+    }
+
+    /**
+     * Finds the fraction of the way through a step at which the temperature crosses a bound, by bisection on the albedo
+     * at the luminosity the step was taken at
+     */
+    template <typename Scalar>
+    float TemperatureCrossing(DaisyWorld<Scalar>& world, const Snapshot& current, float bound) {
+        float low = 0.0, high = 1.0;
+        bool aboveAtLow = ScalarValue(world.GlobalTemperatureFor(previous.albedo, current.luminosity)) > bound;
+        // the luminosity change alone moved the temperature across the bound, at the start of the step
+        if (aboveAtLow == (current.temperature > bound)) return 0.0f;
+        for (int i=0; i<bisectionIterations; i++) {
+            float middle = 0.5f * (low + high);
+            float albedo = previous.albedo + middle * (current.albedo - previous.albedo);
+            bool above = ScalarValue(world.GlobalTemperatureFor(albedo, current.luminosity)) > bound;
+            if (above == aboveAtLow) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return 0.5f * (low + high);
+    }
+
+    public:
+
+    /**
+     * An extinct color has recovered once its proportion rises above this. It is above the amounts that extinct daisies are
+     * boosted to, so that boosting alone does not count as a recovery.
+     */
+    float recoveryThreshold = 0.02;
+
+    /**
+     * The range of global temperatures where daisies can grow, where the growth function of equation (3) is positive
+     */
+    float minHabitableTemperature = 5.0;
+    float maxHabitableTemperature = 40.0;
+
+    // how many times to halve the interval when finding a temperature crossing
+    int bisectionIterations = 20;
+
+    /**
+     * Looks at the world after an update and records any thresholds that were crossed since it was last observed.
+     * The first observation only records the starting state.
+     */
+    template <typename Scalar>
+    void Observe(DaisyWorld<Scalar>& world) {
+        Snapshot current = TakeSnapshot(world);
+        float extinctionThreshold = world.GetExtinctionThreshold();
+        bool roundWorld = world.IsWorldRound();
+        if (!hasPrevious) {
+            for (int i=0; i<World::COLORS; i++) extinct[i] = roundWorld ? current.proportion[i] == 0.0f : current.proportion[i] < extinctionThreshold;
+            habitable = current.temperature >= minHabitableTemperature && current.temperature <= maxHabitableTemperature;
+            previous = current;
+            hasPrevious = true;
+            return;
+        }
+
+        for (int i=0; i<World::COLORS; i++) {
+            float before = previous.proportion[i];
+            float after = current.proportion[i];
+            // proportions move linearly over a step, so the crossing is found by interpolation
+            if (!extinct[i] && roundWorld && after == 0.0f) {
+                Record(WorldEvent::EXTINCTION, i, 1.0f, current);
+                extinct[i] = true;
+            } else if (!extinct[i] && !roundWorld && after < extinctionThreshold) {
+                // the step as the kernel took it, before a color below the threshold was cleared to 0
+                float unclampedAfter = before + ScalarValue(world.GetLastGrowthAmount(i));
+                Record(WorldEvent::EXTINCTION, i, std::clamp((extinctionThreshold - before) / (unclampedAfter - before), 0.0f, 1.0f), current);
+                extinct[i] = true;
+            } else if (extinct[i] && after > recoveryThreshold) {
+                Record(WorldEvent::RECOVERY, i, std::clamp((recoveryThreshold - before) / (after - before), 0.0f, 1.0f), current);
+                extinct[i] = false;
+            }
+        }
+
+        bool nowHabitable = current.temperature >= minHabitableTemperature && current.temperature <= maxHabitableTemperature;
+        if (nowHabitable != habitable) {
+            // the bound that was crossed is the one the temperature is on the far side of
+            float outsideTemperature = habitable ? current.temperature : previous.temperature;
+            float bound = outsideTemperature > maxHabitableTemperature ? maxHabitableTemperature : minHabitableTemperature;
+            Record(habitable ? WorldEvent::LEFT_HABITABLE_BAND : WorldEvent::ENTERED_HABITABLE_BAND, -1, TemperatureCrossing(world, current, bound), current);
+            habitable = nowHabitable;
+        }
+        previous = current;
+    }
+
+    /**
+     * @returns every event detected so far, in the order they happened
+     */
+    const std::vector<WorldEvent>& GetEvents() const {
+        return events;
+    }
+
+    /**
+     * Writes the events to a csv file with one row per event
+     */
+    void WriteLog(const std::string& fileName) const {
+        static const std::string colorNames[World::COLORS] = {"white", "black", "gray"};
+        std::ofstream file(fileName);
+        file << "t,L,event,color" << std::endl;
+        for (const WorldEvent& event : events) {
+            file << event.time << "," << event.luminosity << "," << event.Name() << "," << (event.color < 0 ? "" : colorNames[event.color]) << std::endl;
+        }
+    }
+};
+
+#endif
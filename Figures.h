@@ -0,0 +1,226 @@
+#ifndef FIGURES_H
+#define FIGURES_H
+
+#include "Sweep.h"
+#include "LatitudeProfiles.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A figure drawn as an SVG image, built up from lines, rectangles, and text in pixel coordinates
+ */
+class SvgFigure {
+    int width;
+    int height;
+    std::ostringstream body;
+
+    public:
+
+    SvgFigure(int _width, int _height) : width(_width), height(_height) {
+        body << std::fixed << std::setprecision(1);
+    }
+
+    void Line(float x1, float y1, float x2, float y2, const std::string& stroke = "black", float strokeWidth = 1.0, const std::string& dash = "") {
+        body << "<line x1=\"" << x1 << "\" y1=\"" << y1 << "\" x2=\"" << x2 << "\" y2=\"" << y2 << "\" stroke=\"" << stroke << "\" stroke-width=\"" << strokeWidth << "\"";
+        if (!dash.empty()) body << " stroke-dasharray=\"" << dash << "\"";
+        body << "/>\n";
+    }
+
+    void Polyline(const std::vector<std::pair<float, float>>& points, const std::string& stroke = "black", float strokeWidth = 1.5, const std::string& dash = "") {
+        if (points.size() < 2) return;
+        body << "<polyline fill=\"none\" stroke=\"" << stroke << "\" stroke-width=\"" << strokeWidth << "\"";
+        if (!dash.empty()) body << " stroke-dasharray=\"" << dash << "\"";
+        body << " points=\"";
+        for (const std::pair<float, float>& point : points) body << point.first << "," << point.second << " ";
+        body << "\"/>\n";
+    }
+
+    void Rect(float x, float y, float rectWidth, float rectHeight, const std::string& fill, const std::string& stroke = "none") {
+        body << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << rectWidth << "\" height=\"" << rectHeight << "\" fill=\"" << fill << "\" stroke=\"" << stroke << "\"/>\n";
+    }
+
+    /**
+     * Writes text anchored at a point
+     * @param anchor "start", "middle", or "end"
+     * @param rotation Degrees to rotate the text clockwise about the point
+     */
+    void Text(float x, float y, const std::string& text, int size = 14, const std::string& anchor = "middle", float rotation = 0.0) {
+        body << "<text x=\"" << x << "\" y=\"" << y << "\" font-family=\"sans-serif\" font-size=\"" << size << "\" text-anchor=\"" << anchor << "\"";
+        if (rotation != 0.0f) body << " transform=\"rotate(" << rotation << " " << x << " " << y << ")\"";
+        body << ">" << text << "</text>\n";
+    }
+
+    /**
+     * Writes the figure to an SVG file
+     */
+    void Save(const std::string& fileName) const {
+        std::ofstream file(fileName);
+        file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        file << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height << "\" viewBox=\"0 0 " << width << " " << height << "\">\n";
+        file << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+        file << body.str();
+        file << "</svg>\n";
+    }
+
+    /**
+     * @returns an SVG color for red, green, and blue amounts from 0 to 255
+     */
+    static std::string Color(int red, int green, int blue) {
+        std::ostringstream color;
+        color << "rgb(" << std::clamp(red, 0, 255) << "," << std::clamp(green, 0, 255) << "," << std::clamp(blue, 0, 255) << ")";
+        return color.str();
+    }
+};
+
+/**
+ * A rectangle of a figure that plots data between axis limits
+ */
+struct PlotArea {
+    float left, top, width, height;
+    float xMin, xMax, yMin, yMax;
+
+    /**
+     * @returns the pixel position of a data value along each axis
+     */
+    float X(float x) const {
+        return left + (x - xMin) / (xMax - xMin) * width;
+    }
+
+    float Y(float y) const {
+        return top + height - (y - yMin) / (yMax - yMin) * height;
+    }
+
+    /**
+     * Draws a box around the area, with labelled tick marks along the bottom and left
+     * @param yTickLabels Labels for the y ticks, or empty to label them with their values
+     */
+    void DrawAxes(SvgFigure& figure, const std::string& xLabel, const std::string& yLabel, const std::vector<float>& xTicks, const std::vector<float>& yTicks, const std::vector<std::string>& yTickLabels = {}) const {
+        figure.Rect(left, top, width, height, "none", "black");
+        for (float tick : xTicks) {
+            std::ostringstream label;
+            label << tick;
+            figure.Line(X(tick), top + height, X(tick), top + height + 5);
+            figure.Text(X(tick), top + height + 20, label.str(), 12);
+        }
+        for (size_t i = 0; i < yTicks.size(); i++) {
+            std::ostringstream label;
+            label << yTicks[i];
+            figure.Line(left - 5, Y(yTicks[i]), left, Y(yTicks[i]));
+            figure.Text(left - 8, Y(yTicks[i]) + 4, i < yTickLabels.size() ? yTickLabels[i] : label.str(), 12, "end");
+        }
+        if (!xLabel.empty()) figure.Text(left + width / 2, top + height + 42, xLabel, 15);
+        figure.Text(left - 48, top + height / 2, yLabel, 15, "middle", -90);
+    }
+};
+
+/**
+ * Draws the cover of each enabled color and the global temperature against luminosity, in two panels like the figures
+ * of the Daisyworld paper. The rising part of the sweep is drawn in black and the falling part in gray, so hysteresis
+ * shows as a gap between them.
+ * @param enabled Which colors to draw
+ */
+inline void WriteSweepFigure(const std::string& fileName, const std::vector<SweepPoint<float>>& points, const bool (&enabled)[World::COLORS]) {
+    static const std::string colorNames[World::COLORS] = {"White", "Black", "Gray"};
+    // the line styles of the notebook figures: black daisies solid, white dotted, and gray dash-dotted
+    static const std::string dashes[World::COLORS] = {"2,3", "", "8,3,2,3"};
+    SvgFigure figure(800, 640);
+    PlotArea cover = {80, 40, 680, 240, 0.6, 1.7, 0.0, 0.8};
+    PlotArea temperature = {80, 320, 680, 240, 0.6, 1.7, 0.0, 70.0};
+    cover.DrawAxes(figure, "", "Area %", {}, {0.2, 0.4, 0.6});
+    temperature.DrawAxes(figure, "Solar Luminosity", "Temperature (°C)", {0.6, 0.8, 1.0, 1.2, 1.4, 1.6}, {20, 40, 60});
+
+    // draw the falling part first, so the rising part is drawn over it where they agree
+    for (bool rising : {false, true}) {
+        std::string stroke = rising ? "black" : "rgb(160,160,160)";
+        std::vector<std::pair<float, float>> temperatureLine;
+        std::vector<std::pair<float, float>> coverLines[World::COLORS];
+        for (const SweepPoint<float>& point : points) {
+            if (point.rising != rising || point.luminosity < cover.xMin || point.luminosity > cover.xMax) continue;
+            temperatureLine.push_back({temperature.X(point.luminosity), temperature.Y(std::clamp(point.temperature, temperature.yMin, temperature.yMax))});
+            for (int color = 0; color < World::COLORS; color++) {
+                coverLines[color].push_back({cover.X(point.luminosity), cover.Y(std::min(point.proportion[color], cover.yMax))});
+            }
+        }
+        figure.Polyline(temperatureLine, stroke);
+        for (int color = 0; color < World::COLORS; color++) {
+            if (enabled[color]) figure.Polyline(coverLines[color], stroke, 1.5, dashes[color]);
+        }
+    }
+
+    // legend
+    float legendX = cover.left + 200;
+    for (int color = 0; color < World::COLORS; color++) {
+        if (!enabled[color]) continue;
+        figure.Line(legendX, cover.top + 20, legendX + 30, cover.top + 20, "black", 1.5, dashes[color]);
+        figure.Text(legendX + 36, cover.top + 24, colorNames[color] + " Daisies", 13, "start");
+        legendX += 150;
+    }
+    figure.Line(temperature.left + 20, temperature.top + 20, temperature.left + 50, temperature.top + 20, "black", 1.5);
+    figure.Text(temperature.left + 56, temperature.top + 24, "rising", 13, "start");
+    figure.Line(temperature.left + 120, temperature.top + 20, temperature.left + 150, temperature.top + 20, "rgb(160,160,160)", 1.5);
+    figure.Text(temperature.left + 156, temperature.top + 24, "falling", 13, "start");
+    figure.Save(fileName);
+}
+
+/**
+ * Draws where each color of daisy grows at each luminosity of the rising part of a round world sweep, as a heatmap with
+ * latitude from the pole at the bottom to the equator at the top. Each cell blends red for white daisies, blue for black
+ * daisies, and dark gray for gray daisies in proportion to their cover, over white for bare ground.
+ * @param profiles The cover at each latitude recorded at the end of each plateau of the sweep
+ */
+inline void WriteLatitudeHeatmap(const std::string& fileName, const LatitudeProfileRecorder& profiles) {
+    static const int baseColors[World::COLORS][3] = {{220, 40, 40}, {40, 40, 220}, {70, 70, 70}};
+    std::vector<int> rising;
+    for (int plateau = 0; plateau < profiles.GetRecordedPlateaus(); plateau++) {
+        if (profiles.IsRising(plateau)) rising.push_back(plateau);
+    }
+    if (rising.empty()) return;
+    int latitudes = profiles.GetNumberOfLatitudes();
+    auto luminosity = [&](size_t i) { return profiles.GetLuminosity(rising[i]); };
+
+    SvgFigure figure(800, 700);
+    PlotArea area = {80, 60, 680, 560, luminosity(0), luminosity(rising.size() - 1), 0.0, (float)latitudes};
+    for (size_t i = 0; i < rising.size(); i++) {
+        // each cell reaches halfway to the neighboring luminosities
+        float left = i > 0 ? 0.5f * (luminosity(i - 1) + luminosity(i)) : luminosity(i);
+        float right = i + 1 < rising.size() ? 0.5f * (luminosity(i) + luminosity(i + 1)) : luminosity(i);
+        // neighboring latitudes of the same color are drawn as one rectangle, to keep the file small
+        int runStart = 0;
+        std::string runColor;
+        for (int latitude = 0; latitude <= latitudes; latitude++) {
+            std::string cellColor;
+            if (latitude < latitudes) {
+                float channels[3] = {255, 255, 255};
+                for (int color = 0; color < World::COLORS; color++) {
+                    float proportion = profiles.Cover(rising[i], latitude, color);
+                    for (int c = 0; c < 3; c++) channels[c] += proportion * (baseColors[color][c] - 255);
+                }
+                cellColor = SvgFigure::Color(std::lround(channels[0]), std::lround(channels[1]), std::lround(channels[2]));
+            }
+            if (cellColor == runColor) continue;
+            if (latitude > 0 && runColor != "rgb(255,255,255)") {
+                figure.Rect(area.X(left), area.Y(latitude), area.X(right) - area.X(left) + 0.5f, area.Y(runStart) - area.Y(latitude) + 0.5f, runColor);
+            }
+            runStart = latitude;
+            runColor = cellColor;
+        }
+    }
+    std::vector<float> luminosityTicks;
+    for (float tick = std::ceil(area.xMin * 5) / 5; tick <= area.xMax + 0.001f; tick += 0.2f) luminosityTicks.push_back(std::round(tick * 10) / 10);
+    area.DrawAxes(figure, "Luminosity", "Latitude", luminosityTicks, {0.5f, latitudes - 0.5f}, {"Pole", "Equator"});
+
+    static const std::string names[World::COLORS] = {"White Daisies", "Black Daisies", "Gray Daisies"};
+    for (int color = 0; color < World::COLORS; color++) {
+        figure.Rect(area.left + 140 + 180 * color, area.top - 34, 14, 14, SvgFigure::Color(baseColors[color][0], baseColors[color][1], baseColors[color][2]));
+        figure.Text(area.left + 160 + 180 * color, area.top - 22, names[color], 13, "start");
+    }
+    figure.Save(fileName);
+}
+
+#endif
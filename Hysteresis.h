@@ -0,0 +1,195 @@
+#ifndef HYSTERESIS_H
+#define HYSTERESIS_H
+
+#include "Sweep.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * Measures of the hysteresis loop of a rising and falling luminosity sweep
+ */
+struct HysteresisSummary {
+    /**
+     * A range of luminosities or temperatures, which is NaN when it is empty
+     */
+    struct Range {
+        float min = std::numeric_limits<float>::quiet_NaN();
+        float max = std::numeric_limits<float>::quiet_NaN();
+
+        bool Empty() const {
+            return std::isnan(min);
+        }
+
+        /**
+         * Widens the range to include a value
+         */
+        void Include(float value) {
+            bool empty = Empty();
+            min = empty ? value : std::min(min, value);
+            max = empty ? value : std::max(max, value);
+        }
+    };
+
+    // where each color is established, indexed by color, then 1 for rising and 0 for falling
+    Range survival[World::COLORS][2];
+
+    // how far apart the edges of the survival ranges of each color are between the two parts of the sweep, added over
+    // both edges. 0 if the color survives over the same range both ways.
+    float loopWidth[World::COLORS] = {};
+
+    // the area between the rising and falling temperature curves, in Celsius times luminosity
+    float loopArea = 0.0;
+
+    // the widest range of luminosities where the temperature is regulated on each part of the sweep, and the range of
+    // temperatures within it
+    Range regulatedLuminosity[2];
+    Range regulatedTemperature[2];
+
+    /**
+     * Writes the summary to a csv file with one quantity per row. The bounds of empty ranges, such as the survival of
+     * colors that never established, are left empty.
+     */
+    void Write(const std::string& fileName) const {
+        static const std::string colorNames[World::COLORS] = {"white", "black", "gray"};
+        static const std::string branchNames[2] = {"falling", "rising"};
+        std::ofstream file(fileName);
+        auto writeRange = [&](const std::string& name, const std::string& suffix, const Range& range) {
+            file << name << "_min" << suffix << ",";
+            if (!range.Empty()) file << range.min;
+            file << std::endl << name << "_max" << suffix << ",";
+            if (!range.Empty()) file << range.max;
+            file << std::endl;
+        };
+        file << "quantity,value" << std::endl;
+        for (int color = 0; color < World::COLORS; color++) {
+            for (int branch : {1, 0}) {
+                writeRange(colorNames[color] + "_survival_" + branchNames[branch], "", survival[color][branch]);
+            }
+            file << colorNames[color] << "_loop_width," << loopWidth[color] << std::endl;
+        }
+        file << "loop_area," << loopArea << std::endl;
+        for (int branch : {1, 0}) {
+            writeRange("regulated_" + branchNames[branch], "_L", regulatedLuminosity[branch]);
+            writeRange("regulated_" + branchNames[branch], "_temp", regulatedTemperature[branch]);
+        }
+    }
+};
+
+/**
+ * Collects the points of a sweep as it runs, and measures its hysteresis loop once it is done. The rising and falling
+ * parts may be sampled at different luminosities, as in an adaptive sweep.
+ */
+class HysteresisAnalyzer {
+    // the points of each part of the sweep, 1 for rising and 0 for falling
+    std::vector<SweepPoint<float>> branches[2];
+
+    /**
+     * @returns the temperature of a part of the sweep at a luminosity, interpolating linearly between its points, or NaN
+     * outside of them
+     */
+    float TemperatureAt(const std::vector<SweepPoint<float>>& branch, float luminosity) const {
+        for (size_t i = 0; i + 1 < branch.size(); i++) {
+            const SweepPoint<float>& a = branch[i];
+            const SweepPoint<float>& b = branch[i + 1];
+            if (luminosity < a.luminosity || luminosity > b.luminosity) continue;
+            if (b.luminosity == a.luminosity) return a.temperature;
+            return a.temperature + (luminosity - a.luminosity) / (b.luminosity - a.luminosity) * (b.temperature - a.temperature);
+        }
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    public:
+
+    /**
+     * A color is established where it covers more than this proportion of the planet
+     */
+    float establishedThreshold = 0.01;
+
+    /**
+     * The temperature is regulated where it changes by less than this many Celsius per unit of luminosity. Without
+     * daisies, it changes by about 70 Celsius per unit around luminosity 1.
+     */
+    float regulatedSlope = 30.0;
+
+    /**
+     * Adds the next point of the sweep
+     */
+    void Add(const SweepPoint<float>& point) {
+        branches[point.rising].push_back(point);
+    }
+
+    /**
+     * Adds every point of a finished sweep
+     */
+    void AddAll(const std::vector<SweepPoint<float>>& points) {
+        for (const SweepPoint<float>& point : points) Add(point);
+    }
+
+    /**
+     * @returns the measures of the hysteresis loop of the points added so far
+     */
+    HysteresisSummary Summarize() const {
+        HysteresisSummary summary;
+        std::vector<SweepPoint<float>> sorted[2];
+        for (int branch = 0; branch < 2; branch++) {
+            sorted[branch] = branches[branch];
+            std::sort(sorted[branch].begin(), sorted[branch].end(), [](const SweepPoint<float>& a, const SweepPoint<float>& b) { return a.luminosity < b.luminosity; });
+            for (const SweepPoint<float>& point : sorted[branch]) {
+                for (int color = 0; color < World::COLORS; color++) {
+                    if (point.proportion[color] > establishedThreshold) summary.survival[color][branch].Include(point.luminosity);
+                }
+            }
+
+            // find the widest run of consecutive points where the temperature changes slowly
+            const std::vector<SweepPoint<float>>& points = sorted[branch];
+            size_t runStart = 0;
+            for (size_t i = 1; i <= points.size(); i++) {
+                bool regulated = i < points.size() && points[i].luminosity > points[i - 1].luminosity &&
+                    std::abs(points[i].temperature - points[i - 1].temperature) < regulatedSlope * (points[i].luminosity - points[i - 1].luminosity);
+                if (regulated) continue;
+                float width = points[i - 1].luminosity - points[runStart].luminosity;
+                float widest = summary.regulatedLuminosity[branch].Empty() ? 0.0f : summary.regulatedLuminosity[branch].max - summary.regulatedLuminosity[branch].min;
+                if (width > widest) {
+                    summary.regulatedLuminosity[branch] = HysteresisSummary::Range();
+                    summary.regulatedTemperature[branch] = HysteresisSummary::Range();
+                    for (size_t j = runStart; j < i; j++) {
+                        summary.regulatedLuminosity[branch].Include(points[j].luminosity);
+                        summary.regulatedTemperature[branch].Include(points[j].temperature);
+                    }
+                }
+                runStart = i;
+            }
+        }
+
+        for (int color = 0; color < World::COLORS; color++) {
+            const HysteresisSummary::Range& rising = summary.survival[color][1];
+            const HysteresisSummary::Range& falling = summary.survival[color][0];
+            if (rising.Empty() && falling.Empty()) continue;
+            if (rising.Empty() || falling.Empty()) {
+                // the color only survives one way, so the whole range is part of the loop
+                const HysteresisSummary::Range& range = rising.Empty() ? falling : rising;
+                summary.loopWidth[color] = range.max - range.min;
+                continue;
+            }
+            summary.loopWidth[color] = std::abs(rising.max - falling.max) + std::abs(rising.min - falling.min);
+        }
+
+        // integrate the gap between the temperature curves over the rising luminosities, with the trapezoid rule
+        float previousLuminosity = 0.0, previousGap = std::numeric_limits<float>::quiet_NaN();
+        for (const SweepPoint<float>& point : sorted[1]) {
+            float gap = std::abs(point.temperature - TemperatureAt(sorted[0], point.luminosity));
+            if (!std::isnan(gap) && !std::isnan(previousGap)) {
+                summary.loopArea += 0.5f * (gap + previousGap) * (point.luminosity - previousLuminosity);
+            }
+            previousLuminosity = point.luminosity;
+            previousGap = gap;
+        }
+        return summary;
+    }
+};
+
+#endif
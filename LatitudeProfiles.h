@@ -0,0 +1,95 @@
+#ifndef LATITUDE_PROFILES_H
+#define LATITUDE_PROFILES_H
+
+#include "World.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Records the cover of each color at every latitude of a round world at the end of each luminosity plateau, into an
+ * array allocated up front for the whole sweep. Nothing is written until the sweep is done, and then the array is saved
+ * as one binary matrix rather than as rows of text.
+ *
+ * The binary file holds, in native byte order:
+ * - the 4 characters "DWLP", then the number of plateaus, latitudes, and colors as 32 bit integers
+ * - the luminosity of each plateau as a 32 bit float
+ * - whether each plateau was on the rising part of the sweep as a 32 bit integer, 1 or 0
+ * - the cover as 32 bit floats, indexed by plateau, then latitude from the pole to the equator, then color
+ * Every field is 4 bytes, so with P plateaus the cover starts at byte 16 + 8 P, aligned for numpy.fromfile.
+ */
+class LatitudeProfileRecorder {
+    int plateaus;
+    int latitudes;
+    int recorded = 0;
+    std::vector<float> luminosities;
+    std::vector<int32_t> rising;
+    std::vector<float> cover;
+
+    public:
+
+    /**
+     * @param _plateaus How many plateaus the sweep has. No more than this many are recorded.
+     * @param _latitudes How many internal latitudes the world has
+     */
+    LatitudeProfileRecorder(int _plateaus, int _latitudes)
+        : plateaus(_plateaus), latitudes(_latitudes), luminosities(_plateaus), rising(_plateaus), cover((size_t)_plateaus * _latitudes * World::COLORS) {}
+
+    /**
+     * Copies the current cover at every latitude of a round world into the next plateau. Does nothing once every
+     * plateau has been recorded.
+     * @param isRising Whether the world is on the rising part of the sweep
+     */
+    template <typename Scalar>
+    void Record(DaisyWorld<Scalar>& world, bool isRising) {
+        if (recorded >= plateaus) return;
+        luminosities[recorded] = ScalarValue(world.GetSolarLuminosity());
+        rising[recorded] = isRising;
+        float* profile = &cover[(size_t)recorded * latitudes * World::COLORS];
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            for (int color = 0; color < World::COLORS; color++) {
+                profile[latitude * World::COLORS + color] = ScalarValue(world.GetProportionAtInternalLatitude(color, latitude));
+            }
+        }
+        recorded++;
+    }
+
+    int GetRecordedPlateaus() const {
+        return recorded;
+    }
+
+    int GetNumberOfLatitudes() const {
+        return latitudes;
+    }
+
+    float GetLuminosity(int plateau) const {
+        return luminosities[plateau];
+    }
+
+    bool IsRising(int plateau) const {
+        return rising[plateau];
+    }
+
+    /**
+     * @returns the cover of a color at a latitude at the end of a plateau
+     */
+    float Cover(int plateau, int latitude, int color) const {
+        return cover[((size_t)plateau * latitudes + latitude) * World::COLORS + color];
+    }
+
+    /**
+     * Saves the recorded plateaus to a binary file
+     */
+    void Save(const std::string& fileName) const {
+        std::ofstream file(fileName, std::ios::binary);
+        int32_t dimensions[3] = {recorded, latitudes, World::COLORS};
+        file.write("DWLP", 4);
+        file.write(reinterpret_cast<const char*>(dimensions), sizeof(dimensions));
+        file.write(reinterpret_cast<const char*>(luminosities.data()), recorded * sizeof(float));
+        file.write(reinterpret_cast<const char*>(rising.data()), recorded * sizeof(int32_t));
+        file.write(reinterpret_cast<const char*>(cover.data()), (size_t)recorded * latitudes * World::COLORS * sizeof(float));
+    }
+};
+
+#endif
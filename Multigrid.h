@@ -0,0 +1,114 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include "World.h"
+#include "Equilibrium.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+/**
+ * Describes how to find the equilibrium of a round planet with many more latitudes than a World has. The equilibrium
+ * is found on a coarse grid of latitudes first, then carried over to finer and finer grids as the starting cover of
+ * each, so the finest grids start close to their equilibrium and only need a few iterations.
+ */
+struct MultigridSettings {
+    // how many latitudes the coarsest grid has
+    int coarsestLatitudes = 90;
+    // how many latitudes to find the equilibrium at
+    int latitudes = 10000;
+    // how many times more latitudes each grid has than the one before it
+    int refinement = 2;
+    // how each grid is relaxed to equilibrium
+    EquilibriumSettings equilibrium;
+
+    MultigridSettings() {
+        // a latitude where white and black daisies grow almost equally well only drifts toward one of them slowly, and
+        // finer grids have latitudes ever closer to that balance, so a tighter tolerance than this stalls on them
+        equilibrium.tolerance = 1e-5;
+    }
+};
+
+/**
+ * How relaxing one grid of a multigrid solve went
+ */
+struct MultigridLevel {
+    int latitudes;
+    EquilibriumResult relaxation;
+    double seconds;
+};
+
+/**
+ * The equilibrium found by a multigrid solve, and how each grid went
+ */
+struct MultigridResult {
+    // the proportion of each enabled color at each latitude of the finest grid, ordered by latitude and then color
+    std::vector<double> cover;
+    int latitudes = 0;
+    std::vector<MultigridLevel> levels;
+
+    /**
+     * @returns whether every grid reached equilibrium
+     */
+    bool Converged() const {
+        for (const MultigridLevel& level : levels) {
+            if (!level.relaxation.converged) return false;
+        }
+        return !levels.empty();
+    }
+};
+
+/**
+ * Resamples a profile of cover to another number of latitudes, interpolating linearly between the nearest latitudes
+ * of the profile, where the first and last latitudes of both are the pole and the equator
+ * @param cover The proportion of each color at each latitude, ordered by latitude and then color
+ * @param colors How many colors each latitude has
+ * @returns the resampled profile, ordered the same way
+ */
+inline std::vector<double> ResampleLatitudeProfile(const std::vector<double>& cover, int colors, int fromLatitudes, int toLatitudes) {
+    std::vector<double> resampled((size_t)toLatitudes * colors);
+    for (int latitude = 0; latitude < toLatitudes; latitude++) {
+        double position = toLatitudes > 1 ? (double)latitude * (fromLatitudes - 1) / (toLatitudes - 1) : 0.0;
+        int below = std::min((int)position, fromLatitudes - 1);
+        int above = std::min(below + 1, fromLatitudes - 1);
+        double fraction = position - below;
+        for (int a = 0; a < colors; a++) {
+            resampled[(size_t)latitude * colors + a] = (1 - fraction) * cover[(size_t)below * colors + a] + fraction * cover[(size_t)above * colors + a];
+        }
+    }
+    return resampled;
+}
+
+/**
+ * Finds the equilibrium of a round planet with the parameters, luminosity, and enabled colors of a world at a higher
+ * resolution, starting from the current cover of the world and relaxing it with World::UpdateLatitudeProfile on grids
+ * from the coarsest to the finest. The world itself is unchanged.
+ */
+inline MultigridResult SolveLatitudeMultigrid(World& world, const MultigridSettings& settings) {
+    MultigridResult result;
+    int colors = 0;
+    for (int i=0; i<World::COLORS; i++) colors += world.IsColorEnabled(i);
+    if (colors == 0) return result;
+    std::vector<double> worldCover = world.GetCoverVector();
+    int worldLatitudes = worldCover.size() / colors;
+    int latitudes = std::min(settings.coarsestLatitudes, settings.latitudes);
+    result.cover = ResampleLatitudeProfile(worldCover, colors, worldLatitudes, latitudes);
+    // the updates run so far, so each iteration continues the profile's updates rather than starting them over
+    int updates = 0;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        EquilibriumResult relaxation = RelaxFixedPoint(result.cover, colors, [&](std::vector<double>& cover) {
+            world.UpdateLatitudeProfile(cover, latitudes, settings.equilibrium.updatesPerIteration, updates);
+            updates += settings.equilibrium.updatesPerIteration;
+        }, settings.equilibrium);
+        result.levels.push_back({latitudes, relaxation, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()});
+        if (latitudes >= settings.latitudes) break;
+        int finer = std::min(latitudes * std::max(settings.refinement, 2), settings.latitudes);
+        result.cover = ResampleLatitudeProfile(result.cover, colors, latitudes, finer);
+        latitudes = finer;
+    }
+    result.latitudes = latitudes;
+    return result;
+}
+
+#endif
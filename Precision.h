@@ -0,0 +1,69 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * A proportion from 0 to 1 stored as a 16 bit fixed point number, in steps of 1 / 65535. Takes a quarter of the
+ * memory of a double. A 16 bit float would be coarser for all but the smallest proportions, where daisies die anyway.
+ */
+struct FixedProportion16 {
+    static constexpr double STEPS = 65535.0;
+
+    uint16_t bits = 0;
+
+    FixedProportion16() = default;
+
+    /**
+     * Rounds a proportion to the nearest step
+     */
+    explicit FixedProportion16(double value) : FixedProportion16(value, 0x8000u << 16) {}
+
+    /**
+     * Rounds a proportion up or down at random to one of the two steps around it, with the chance of rounding up
+     * proportional to how close it is to the upper one, so the rounding is unbiased on average
+     * @param noise Uniformly random bits
+     */
+    FixedProportion16(double value, uint32_t noise) {
+        // the upper 16 bits of the noise are added to the 16 bits below the step in fixed point
+        int64_t scaled = ((int64_t)(std::min(std::max(value, 0.0), 1.0) * (STEPS * 65536.0)) + (noise >> 16)) >> 16;
+        bits = std::min<int64_t>(scaled, 65535);
+    }
+
+    operator double() const {
+        return bits * (1.0 / STEPS);
+    }
+};
+
+/**
+ * @returns random looking bits for stochastically rounding the proportion stored at an index on a step, which are the
+ * same every time for the same index and step so runs are reproducible
+ */
+inline uint32_t RoundingNoise(uint32_t index, uint32_t step) {
+    uint32_t hash = index * 0x9E3779B1u ^ step * 0x85EBCA77u;
+    hash ^= hash >> 16;
+    hash *= 0x7FEB352Du;
+    hash ^= hash >> 15;
+    hash *= 0x846CA68Bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * Rounds a proportion computed in double precision to how it is stored. Float and double storage round to nearest,
+ * and fixed point rounds stochastically, so updates smaller than their precision still move the proportion on
+ * average rather than being lost.
+ * @param noise Uniformly random bits, from RoundingNoise
+ */
+template <typename Stored>
+inline Stored StoreProportion(double value, uint32_t) {
+    return static_cast<Stored>(value);
+}
+
+template <>
+inline FixedProportion16 StoreProportion<FixedProportion16>(double value, uint32_t noise) {
+    return FixedProportion16(value, noise);
+}
+
+#endif
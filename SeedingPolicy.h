@@ -0,0 +1,212 @@
+#ifndef SEEDING_POLICY_H
+#define SEEDING_POLICY_H
+
+#include "emp/math/Random.hpp"
+#include <cmath>
+
+/**
+ * How daisies that have died out are given a chance to start growing again. The default policy is the one used by the
+ * Daisyworld tests: extinct colors are boosted whenever the luminosity changes and again halfway through each luminosity.
+ * The other mechanisms are applied inside the world's update loop, and may be combined.
+ */
+struct SeedingPolicy {
+    /**
+     * Whether to boost extinct colors when a luminosity sweep changes the luminosity
+     */
+    bool seedOnLuminosityChange = true;
+
+    /**
+     * Whether to boost extinct colors halfway through the time a luminosity sweep spends at each luminosity
+     */
+    bool seedHalfway = true;
+
+    /**
+     * The proportion that colors below it are raised to when seeded, on flat and on round worlds
+     */
+    float flatSeedAmount = 0.01;
+    float roundSeedAmount = 0.001;
+
+    /**
+     * Seed every enabled color every this many updates, or never if 0
+     */
+    int seedingPeriod = 0;
+
+    /**
+     * Whether to seed a color some time after it goes extinct over the whole planet
+     */
+    bool seedOnExtinction = false;
+
+    /**
+     * How many updates after going extinct a color is seeded
+     */
+    int extinctionSeedingDelay = 100;
+
+    /**
+     * The chance per update that daisies of each enabled color immigrate to each latitude, and how much cover they add
+     */
+    float immigrationProbability = 0.0;
+    float immigrationAmount = 0.001;
+
+    /**
+     * On round worlds, the rate per time unit at which daisies spread to neighboring latitudes, or 0 for no dispersal
+     */
+    float dispersalRate = 0.0;
+
+    /**
+     * Seed for the random number generator used for immigration
+     */
+    int randomSeed = 1;
+
+    /**
+     * @returns a policy that seeds every color every period updates instead of boosting during sweeps
+     */
+    static SeedingPolicy Periodic(int period) {
+        SeedingPolicy policy = WithoutSweepBoosts();
+        policy.seedingPeriod = period;
+        return policy;
+    }
+
+    /**
+     * @returns a policy that seeds a color delay updates after it goes extinct instead of boosting during sweeps
+     */
+    static SeedingPolicy OnExtinction(int delay = 100) {
+        SeedingPolicy policy = WithoutSweepBoosts();
+        policy.seedOnExtinction = true;
+        policy.extinctionSeedingDelay = delay;
+        return policy;
+    }
+
+    /**
+     * @returns a policy where daisies randomly immigrate instead of being boosted during sweeps
+     */
+    static SeedingPolicy Immigration(float probability, float amount = 0.001) {
+        SeedingPolicy policy = WithoutSweepBoosts();
+        policy.immigrationProbability = probability;
+        policy.immigrationAmount = amount;
+        return policy;
+    }
+
+    /**
+     * @returns the default policy, plus dispersal between neighboring latitudes of a round world
+     */
+    static SeedingPolicy Dispersal(float rate) {
+        SeedingPolicy policy;
+        policy.dispersalRate = rate;
+        return policy;
+    }
+
+    /**
+     * @returns a policy that never seeds
+     */
+    static SeedingPolicy WithoutSweepBoosts() {
+        SeedingPolicy policy;
+        policy.seedOnLuminosityChange = false;
+        policy.seedHalfway = false;
+        return policy;
+    }
+};
+
+/**
+ * Carries out a seeding policy from inside a world's update loop. Once per update, BeginStep decides which colors are
+ * seeded, then SeedCover is applied to each patch of ground as it is updated, so seeding needs no extra pass over the
+ * latitudes of a round world.
+ */
+class Seeder {
+    SeedingPolicy policy;
+
+    int updatesUntilPeriodicSeeding;
+
+    // for each color, how many updates until it is seeded after going extinct, or -1 if it is not waiting to be seeded
+    int updatesUntilExtinctionSeeding[3] = {-1, -1, -1};
+
+    // whether each color had any daisies at the end of the last update
+    bool wasAlive[3] = {true, true, true};
+
+    // which colors are seeded this update
+    bool seedingThisStep[3] = {};
+
+    // how many more patches of ground and colors are visited before the next immigration
+    long cellsUntilImmigration;
+
+    emp::Random random;
+
+    /**
+     * @returns how many patch and color pairs are visited until the next immigration, drawn from a geometric distribution
+     */
+    long NextImmigrationGap() {
+        if (policy.immigrationProbability >= 1.0f) return 1;
+        return 1 + (long)std::floor(std::log(1.0 - random.GetDouble()) / std::log(1.0 - policy.immigrationProbability));
+    }
+
+    public:
+
+    Seeder(const SeedingPolicy& _policy = SeedingPolicy())
+        : policy(_policy), updatesUntilPeriodicSeeding(_policy.seedingPeriod), random(_policy.randomSeed) {
+        cellsUntilImmigration = policy.immigrationProbability > 0.0f ? NextImmigrationGap() : 0;
+    }
+
+    const SeedingPolicy& GetPolicy() const {
+        return policy;
+    }
+
+    /**
+     * Decides which colors are seeded during this update. Call once at the start of every update.
+     * @returns whether SeedCover needs to be called on each patch of ground this update
+     */
+    bool BeginStep() {
+        bool seeding = false;
+        bool periodic = false;
+        if (policy.seedingPeriod > 0 && --updatesUntilPeriodicSeeding <= 0) {
+            periodic = true;
+            updatesUntilPeriodicSeeding = policy.seedingPeriod;
+        }
+        for (int i=0; i<3; i++) {
+            bool afterExtinction = updatesUntilExtinctionSeeding[i] >= 0 && updatesUntilExtinctionSeeding[i]-- == 0;
+            seedingThisStep[i] = periodic || afterExtinction;
+            seeding = seeding || seedingThisStep[i];
+        }
+        return seeding || policy.immigrationProbability > 0.0f;
+    }
+
+    /**
+     * Seeds one patch of ground after it has been updated. Immigrants only land on bare ground, so they are capped at
+     * the bare ground left and are lost if there is none.
+     * @param proportion The proportion of the patch covered by each color of daisy
+     * @param enabled Whether each color is allowed to grow
+     * @param seedAmount The proportion seeded colors are raised to
+     */
+    template <typename Scalar>
+    void SeedCover(Scalar (&proportion)[3], const bool (&enabled)[3], float seedAmount) {
+        for (int i=0; i<3; i++) {
+            if (!enabled[i]) continue;
+            if (seedingThisStep[i] && proportion[i] < seedAmount) proportion[i] = seedAmount;
+            if (cellsUntilImmigration > 0 && --cellsUntilImmigration == 0) {
+                Scalar bareGround = 1 - proportion[0] - proportion[1] - proportion[2];
+                if (bareGround > 0.0f) proportion[i] += bareGround < policy.immigrationAmount ? bareGround : Scalar(policy.immigrationAmount);
+                cellsUntilImmigration = NextImmigrationGap();
+            }
+        }
+    }
+
+    /**
+     * @returns whether EndStep needs the total cover of each color, to seed colors after they go extinct
+     */
+    bool TracksExtinctions() const {
+        return policy.seedOnExtinction;
+    }
+
+    /**
+     * Schedules seeding for colors that went extinct during this update
+     * @param totals The total cover of each color over the planet after this update
+     */
+    template <typename Scalar>
+    void EndStep(const Scalar (&totals)[3]) {
+        for (int i=0; i<3; i++) {
+            bool alive = totals[i] > 0.0f;
+            if (wasAlive[i] && !alive) updatesUntilExtinctionSeeding[i] = policy.extinctionSeedingDelay;
+            wasAlive[i] = alive;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,341 @@
+#ifndef STABILITY_H
+#define STABILITY_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * The Jacobian of the rate of change of the daisies with respect to their proportions. The unknowns are the proportions of
+ * each enabled color at each latitude, ordered by latitude then color, and a flat world has a single latitude.
+ * Latitudes only interact through the global albedo, so the Jacobian is block diagonal with one small block per
+ * latitude, plus a rank one term through the global albedo:
+ * J = blocks + albedoSensitivity * albedoGradient^T
+ */
+struct GrowthJacobian {
+    // how many enabled colors there are, which is the size of each block
+    int colorsPerBlock = 0;
+    int numberOfBlocks = 0;
+
+    // each block stored by rows, one after another
+    std::vector<double> blocks;
+
+    // how much the growth rate of each unknown changes with the global albedo
+    std::vector<double> albedoSensitivity;
+
+    // how much the global albedo changes with each unknown
+    std::vector<double> albedoGradient;
+
+    /**
+     * @returns the number of unknowns
+     */
+    int Size() const {
+        return colorsPerBlock * numberOfBlocks;
+    }
+
+    /**
+     * @returns the entry of the Jacobian at this row and column
+     */
+    double Entry(int row, int column) const {
+        double entry = albedoSensitivity[row] * albedoGradient[column];
+        int block = row / colorsPerBlock;
+        if (column / colorsPerBlock == block) {
+            entry += blocks[(block * colorsPerBlock + row % colorsPerBlock) * colorsPerBlock + column % colorsPerBlock];
+        }
+        return entry;
+    }
+};
+
+/**
+ * How stable a steady state is
+ */
+struct StabilityResult {
+    // the eigenvalue of the Jacobian with the largest real part, which sets how quickly the slowest disturbance decays
+    double leadingEigenvalueReal = std::numeric_limits<double>::quiet_NaN();
+    double leadingEigenvalueImaginary = std::numeric_limits<double>::quiet_NaN();
+
+    /**
+     * @returns how many time units it takes a small disturbance to shrink by a factor of e, or infinity if the
+     * steady state is unstable
+     */
+    double RecoveryTime() const {
+        return leadingEigenvalueReal < 0.0 ? -1.0 / leadingEigenvalueReal : std::numeric_limits<double>::infinity();
+    }
+};
+
+/**
+ * Finds the eigenvalues of a matrix, where they may be complex
+ */
+class EigenvalueSolver {
+    /**
+     * Reduces a square matrix to upper Hessenberg form with the same eigenvalues, using Householder reflections
+     */
+    static void ReduceToHessenberg(std::vector<std::vector<double>>& a) {
+        int n = a.size();
+        for (int k = 0; k < n - 2; k++) {
+            double norm = 0.0;
+            for (int i = k + 1; i < n; i++) norm += a[i][k] * a[i][k];
+            norm = std::sqrt(norm);
+            if (norm == 0.0) continue;
+            double alpha = a[k + 1][k] > 0.0 ? -norm : norm;
+            std::vector<double> v(n, 0.0);
+            for (int i = k + 1; i < n; i++) v[i] = a[i][k];
+            v[k + 1] -= alpha;
+            double vNorm = 0.0;
+            for (int i = k + 1; i < n; i++) vNorm += v[i] * v[i];
+            if (vNorm == 0.0) continue;
+            // a = (I - 2 v v^T / v^T v) a (I - 2 v v^T / v^T v)
+            for (int j = 0; j < n; j++) {
+                double dot = 0.0;
+                for (int i = k + 1; i < n; i++) dot += v[i] * a[i][j];
+                for (int i = k + 1; i < n; i++) a[i][j] -= 2.0 * v[i] * dot / vNorm;
+            }
+            for (int i = 0; i < n; i++) {
+                double dot = 0.0;
+                for (int j = k + 1; j < n; j++) dot += a[i][j] * v[j];
+                for (int j = k + 1; j < n; j++) a[i][j] -= 2.0 * dot * v[j] / vNorm;
+            }
+        }
+    }
+
+    /**
+     * Finds the eigenvalues of an upper Hessenberg matrix with the shifted QR algorithm, deflating one real eigenvalue or
+     * one complex pair at a time
+     * @param h The matrix, which is overwritten
+     * @param real Receives the real parts of the eigenvalues
+     * @param imaginary Receives the imaginary parts of the eigenvalues
+     */
+    static void HessenbergEigenvalues(std::vector<std::vector<double>>& h, std::vector<double>& real, std::vector<double>& imaginary) {
+        int n = h.size();
+        real.assign(n, 0.0);
+        imaginary.assign(n, 0.0);
+        double norm = 0.0;
+        for (int i = 0; i < n; i++) {
+            for (int j = std::max(i - 1, 0); j < n; j++) norm += std::abs(h[i][j]);
+        }
+        // last is the index of the bottom of the unreduced part of the matrix
+        int last = n - 1;
+        double exceptionalShift = 0.0;
+        int iterations = 0;
+        while (last >= 0) {
+            // find the start of the unreduced block that ends at last
+            int first = last;
+            while (first > 0) {
+                double scale = std::abs(h[first - 1][first - 1]) + std::abs(h[first][first]);
+                if (scale == 0.0) scale = norm;
+                if (std::abs(h[first][first - 1]) + scale == scale) {
+                    h[first][first - 1] = 0.0;
+                    break;
+                }
+                first--;
+            }
+            double x = h[last][last];
+            if (first == last) {
+                // a single real eigenvalue has split off
+                real[last] = x + exceptionalShift;
+                last--;
+                iterations = 0;
+                continue;
+            }
+            double y = h[last - 1][last - 1];
+            double w = h[last][last - 1] * h[last - 1][last];
+            if (first == last - 1) {
+                // a 2x2 block has split off, with either two real eigenvalues or a complex pair
+                double p = 0.5 * (y - x);
+                double q = p * p + w;
+                double z = std::sqrt(std::abs(q));
+                x += exceptionalShift;
+                if (q >= 0.0) {
+                    z = p + (p >= 0.0 ? z : -z);
+                    real[last - 1] = real[last] = x + z;
+                    if (z != 0.0) real[last] = x - w / z;
+                } else {
+                    real[last - 1] = real[last] = x + p;
+                    imaginary[last - 1] = z;
+                    imaginary[last] = -z;
+                }
+                last -= 2;
+                iterations = 0;
+                continue;
+            }
+            if (iterations == 60) {
+                // did not converge; give up on the rest of the matrix
+                for (int i = 0; i <= last; i++) real[i] = std::numeric_limits<double>::quiet_NaN();
+                return;
+            }
+            if (iterations == 10 || iterations == 20) {
+                // an exceptional shift, to break cycles
+                exceptionalShift += x;
+                for (int i = 0; i <= last; i++) h[i][i] -= x;
+                double s = std::abs(h[last][last - 1]) + std::abs(h[last - 1][last - 2]);
+                x = y = 0.75 * s;
+                w = -0.4375 * s * s;
+            }
+            iterations++;
+            // look for two consecutive small subdiagonal entries, to start the double shift step from
+            int m;
+            double p = 0.0, q = 0.0, r = 0.0, z;
+            for (m = last - 2; m >= first; m--) {
+                z = h[m][m];
+                r = x - z;
+                double s = y - z;
+                p = (r * s - w) / h[m + 1][m] + h[m][m + 1];
+                q = h[m + 1][m + 1] - z - r - s;
+                r = h[m + 2][m + 1];
+                s = std::abs(p) + std::abs(q) + std::abs(r);
+                p /= s;
+                q /= s;
+                r /= s;
+                if (m == first) break;
+                double u = std::abs(h[m][m - 1]) * (std::abs(q) + std::abs(r));
+                double v = std::abs(p) * (std::abs(h[m - 1][m - 1]) + std::abs(z) + std::abs(h[m + 1][m + 1]));
+                if (u + v == v) break;
+            }
+            for (int i = m + 2; i <= last; i++) {
+                h[i][i - 2] = 0.0;
+                if (i != m + 2) h[i][i - 3] = 0.0;
+            }
+            // the Francis double shift QR step, chasing the bulge down the block
+            for (int k = m; k <= last - 1; k++) {
+                if (k != m) {
+                    p = h[k][k - 1];
+                    q = h[k + 1][k - 1];
+                    r = k != last - 1 ? h[k + 2][k - 1] : 0.0;
+                    x = std::abs(p) + std::abs(q) + std::abs(r);
+                    if (x != 0.0) {
+                        p /= x;
+                        q /= x;
+                        r /= x;
+                    }
+                }
+                double s = std::sqrt(p * p + q * q + r * r);
+                if (p < 0.0) s = -s;
+                if (s == 0.0) continue;
+                if (k == m) {
+                    if (first != m) h[k][k - 1] = -h[k][k - 1];
+                } else {
+                    h[k][k - 1] = -s * x;
+                }
+                p += s;
+                x = p / s;
+                y = q / s;
+                z = r / s;
+                q /= p;
+                r /= p;
+                for (int j = k; j <= last; j++) {
+                    p = h[k][j] + q * h[k + 1][j];
+                    if (k != last - 1) {
+                        p += r * h[k + 2][j];
+                        h[k + 2][j] -= p * z;
+                    }
+                    h[k + 1][j] -= p * y;
+                    h[k][j] -= p * x;
+                }
+                int bottom = std::min(last, k + 3);
+                for (int i = first; i <= bottom; i++) {
+                    p = x * h[i][k] + y * h[i][k + 1];
+                    if (k != last - 1) {
+                        p += z * h[i][k + 2];
+                        h[i][k + 2] -= p * r;
+                    }
+                    h[i][k + 1] -= p * q;
+                    h[i][k] -= p;
+                }
+            }
+        }
+    }
+
+    public:
+
+    /**
+     * Finds every eigenvalue of a dense square matrix
+     * @param a The matrix, stored by rows
+     * @param real Receives the real parts of the eigenvalues
+     * @param imaginary Receives the imaginary parts of the eigenvalues
+     */
+    static void Eigenvalues(std::vector<std::vector<double>> a, std::vector<double>& real, std::vector<double>& imaginary) {
+        ReduceToHessenberg(a);
+        HessenbergEigenvalues(a, real, imaginary);
+    }
+};
+
+/**
+ * Finds the leading eigenvalue of the growth Jacobian at a steady state, with a dense eigenvalue solver. A World has at
+ * most 90 latitudes of 3 colors, so the Jacobian has at most 270 unknowns, few enough to solve densely.
+ */
+class StabilityAnalyzer {
+    GrowthJacobian jacobian;
+
+    public:
+
+    StabilityAnalyzer(const GrowthJacobian& _jacobian) : jacobian(_jacobian) {}
+
+    /**
+     * Takes out the unknowns whose rows of the Jacobian only have a diagonal entry, such as colors that are extinct at a
+     * latitude. The Jacobian is block triangular once they are ordered last, so each of their diagonal entries is an
+     * eigenvalue by itself. Near a tipping point there are many of these close to zero, so their diagonals are moved far
+     * to the left, out of the way of the eigenvalues of the rest of the system.
+     * @returns the largest eigenvalue of the decoupled unknowns, or -infinity if there are none
+     */
+    double DeflateDecoupledUnknowns() {
+        int k = jacobian.colorsPerBlock;
+        int n = jacobian.Size();
+        double largest = -std::numeric_limits<double>::infinity();
+        double farLeft = -1.0;
+        std::vector<bool> decoupled(n, false);
+        for (int i = 0; i < n; i++) {
+            bool onlyDiagonal = jacobian.albedoSensitivity[i] == 0.0;
+            for (int j = 0; j < k && onlyDiagonal; j++) {
+                if (j != i % k && jacobian.blocks[i * k + j] != 0.0) onlyDiagonal = false;
+            }
+            double diagonal = jacobian.blocks[i * k + i % k];
+            farLeft = std::min(farLeft, 10.0 * (diagonal - std::abs(jacobian.albedoSensitivity[i])) - 1.0);
+            if (!onlyDiagonal) continue;
+            largest = std::max(largest, diagonal);
+            decoupled[i] = true;
+        }
+        for (int i = 0; i < n; i++) {
+            if (decoupled[i]) jacobian.blocks[i * k + i % k] = farLeft;
+        }
+        return largest;
+    }
+
+    /**
+     * @returns the leading eigenvalue of the Jacobian
+     */
+    StabilityResult Analyze() {
+        StabilityResult result;
+        int n = jacobian.Size();
+        if (n == 0) return result;
+        double decoupledLeading = DeflateDecoupledUnknowns();
+        result = AnalyzeCoupled();
+        if (decoupledLeading > result.leadingEigenvalueReal || std::isnan(result.leadingEigenvalueReal)) {
+            result.leadingEigenvalueReal = decoupledLeading;
+            result.leadingEigenvalueImaginary = 0.0;
+        }
+        return result;
+    }
+
+    private:
+
+    /**
+     * @returns the leading eigenvalue of the Jacobian, after decoupled unknowns have been deflated
+     */
+    StabilityResult AnalyzeCoupled() {
+        StabilityResult result;
+        int n = jacobian.Size();
+        std::vector<std::vector<double>> dense(n, std::vector<double>(n));
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) dense[i][j] = jacobian.Entry(i, j);
+        }
+        std::vector<double> real, imaginary;
+        EigenvalueSolver::Eigenvalues(dense, real, imaginary);
+        int leading = std::max_element(real.begin(), real.end()) - real.begin();
+        result.leadingEigenvalueReal = real[leading];
+        result.leadingEigenvalueImaginary = std::abs(imaginary[leading]);
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SUMMATION_H
+#define SUMMATION_H
+
+#include "Dual.h"
+#include <cmath>
+#include <cstddef>
+
+/**
+ * How sums over the latitudes of a round planet are added up
+ */
+enum class Summation {
+    /**
+     * Adds the terms in pairs, then the pair sums in pairs, and so on, with the smallest blocks added into several
+     * independent partial sums the compiler can vectorize. The rounding error grows with the log of the number of
+     * terms, rather than with the number of terms as when adding them one at a time.
+     */
+    PAIRWISE,
+
+    /**
+     * Adds the terms one at a time, carrying the rounding error of each addition into the next (Neumaier's improved
+     * Kahan summation). The rounding error doesn't grow with the number of terms, but the additions can't be vectorized.
+     */
+    COMPENSATED
+};
+
+/**
+ * @returns the size of a term, for deciding which part of a compensated addition loses precision
+ */
+template <typename T>
+float SummandMagnitude(const T& x) {
+    return std::abs(ScalarValue(x));
+}
+
+inline double SummandMagnitude(double x) {
+    return std::abs(x);
+}
+
+inline long double SummandMagnitude(long double x) {
+    return std::abs(x);
+}
+
+/**
+ * @returns the sum of some values, added pairwise
+ */
+template <typename T>
+T PairwiseSum(const T* values, size_t count) {
+    // blocks this small are added into independent partial sums, one per lane
+    constexpr size_t BLOCK = 64;
+    constexpr size_t LANES = 8;
+    if (count <= BLOCK) {
+        T partial[LANES] = {};
+        size_t i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            for (size_t lane = 0; lane < LANES; lane++) partial[lane] += values[i + lane];
+        }
+        for (size_t lane = 0; i < count; i++, lane++) partial[lane] += values[i];
+        for (size_t width = LANES / 2; width > 0; width /= 2) {
+            for (size_t lane = 0; lane < width; lane++) partial[lane] += partial[lane + width];
+        }
+        return partial[0];
+    }
+    // split on a multiple of the block size, so every block but the last is full
+    size_t half = (count / 2 + BLOCK - 1) / BLOCK * BLOCK;
+    return PairwiseSum(values, half) + PairwiseSum(values + half, count - half);
+}
+
+/**
+ * @returns the sum of some values, added with compensation for the rounding error of each addition
+ */
+template <typename T>
+T CompensatedSum(const T* values, size_t count) {
+    T sum = T();
+    T compensation = T();
+    for (size_t i = 0; i < count; i++) {
+        T next = sum + values[i];
+        // the low order part lost by the addition comes from whichever of the two is smaller
+        if (SummandMagnitude(sum) >= SummandMagnitude(values[i])) {
+            compensation += (sum - next) + values[i];
+        } else {
+            compensation += (values[i] - next) + sum;
+        }
+        sum = next;
+    }
+    return sum + compensation;
+}
+
+/**
+ * @returns the sum of some values, added up the given way
+ */
+template <typename T>
+T Sum(const T* values, size_t count, Summation summation) {
+    return summation == Summation::COMPENSATED ? CompensatedSum(values, count) : PairwiseSum(values, count);
+}
+
+#endif
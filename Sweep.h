@@ -0,0 +1,424 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "World.h"
+#include "Events.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * The model constants that may be changed between runs, for calibration and parameter scans
+ */
+struct ModelParameters {
+    /**
+     * Indexes of each parameter in values
+     */
+    enum { DEATH_RATE, WHITE_ALBEDO, BLACK_ALBEDO, GRAY_ALBEDO, CONDUCTIVITY, COUNT };
+
+    /**
+     * The value of each parameter, defaulting to those of the Daisyworld paper
+     */
+    float values[COUNT] = {0.3, 0.75, 0.25, 0.5, 20};
+
+    /**
+     * @returns the name of a parameter, for output
+     */
+    static std::string Name(int parameter) {
+        static const std::string names[COUNT] = {"deathRate", "whiteAlbedo", "blackAlbedo", "grayAlbedo", "conductivityConstant"};
+        return names[parameter];
+    }
+
+    /**
+     * @returns the smallest physically meaningful value of a parameter
+     */
+    static float LowerBound(int parameter) {
+        return parameter == CONDUCTIVITY ? 0.0 : 0.001;
+    }
+
+    /**
+     * @returns the largest physically meaningful value of a parameter
+     */
+    static float UpperBound(int parameter) {
+        return parameter == CONDUCTIVITY ? 100.0 : (parameter == DEATH_RATE ? 1.0 : 0.999);
+    }
+
+    /**
+     * Sets a parameter of a world
+     * @param world The world
+     * @param parameter Which parameter to set
+     * @param value The value of the parameter, which may be a seeded Dual number to differentiate with respect to it
+     */
+    template <typename Scalar>
+    static void Set(DaisyWorld<Scalar>& world, int parameter, Scalar value) {
+        switch (parameter) {
+            case DEATH_RATE: world.SetDeathRate(value); break;
+            case WHITE_ALBEDO: world.SetFlowerAlbedo(World::WHITE, value); break;
+            case BLACK_ALBEDO: world.SetFlowerAlbedo(World::BLACK, value); break;
+            case GRAY_ALBEDO: world.SetFlowerAlbedo(World::GRAY, value); break;
+            case CONDUCTIVITY: world.SetConductivityConstant(value); break;
+        }
+    }
+
+    /**
+     * Sets all of these parameters on a world
+     */
+    template <typename Scalar>
+    void ApplyTo(DaisyWorld<Scalar>& world) const {
+        for (int i=0; i<COUNT; i++) {
+            Set(world, i, Scalar(values[i]));
+        }
+    }
+};
+
+/**
+ * Describes a sweep where solar luminosity rises from a minimum to a maximum and falls back again,
+ * letting the world stabilize at each luminosity
+ */
+struct SweepSettings {
+    bool whiteEnabled = true;
+    bool blackEnabled = true;
+    bool grayEnabled = false;
+    bool roundWorld = false;
+    float minLuminosity = 0.5;
+    float maxLuminosity = 1.7;
+    float luminosityStep = 0.01;
+    // how long in time units to allow the world to stabilize after the luminosity has changed
+    int timePerLuminosity = 500;
+    // how daisies that have died out are given a chance to grow again
+    SeedingPolicy seeding;
+    // whether to find the leading eigenvalue of the growth Jacobian at each luminosity
+    bool analyzeStability = false;
+    // whether to solve for the steady state at each luminosity instead of running the world, when only one color grows
+    // on a flat world. Other sweeps are always run.
+    bool solveAnalytically = false;
+
+    /**
+     * @returns how many luminosity steps there are between the minimum and maximum luminosity
+     */
+    int NumberOfLuminosityTrials() const {
+        return std::round((maxLuminosity - minLuminosity) / luminosityStep);
+    }
+
+    /**
+     * @returns the only color of daisy that grows, if the world is flat and the seeding policy only boosts during the
+     * sweep, so the steady states can be solved for. Otherwise -1.
+     */
+    int SingleSpeciesColor() const {
+        if (roundWorld || seeding.seedingPeriod > 0 || seeding.seedOnExtinction || seeding.immigrationProbability > 0.0f) return -1;
+        if (whiteEnabled + blackEnabled + grayEnabled != 1) return -1;
+        return whiteEnabled ? World::WHITE : (blackEnabled ? World::BLACK : World::GRAY);
+    }
+};
+
+/**
+ * How an adaptive sweep chooses its luminosity steps. A step is taken again at half the size if the state strays from
+ * the line through the two points before it, or a color dies out or becomes established during it. The next step is
+ * doubled if the state stayed close to the line, staying between the smallest and largest steps. Smooth parts of the
+ * curve are crossed in a few large steps, while abrupt ones are resolved to the smallest step.
+ */
+struct AdaptiveStepSettings {
+    float minStep = 0.001;
+    float maxStep = 0.1;
+    // the largest distance of the state from the line through the previous two points allowed after one step, unless
+    // the step is already the smallest
+    float errorTolerance = 0.01;
+    // how much a difference in global temperature of 1 Celsius counts, compared to a difference in the proportion of a
+    // color of 1
+    float temperatureWeight = 0.01;
+};
+
+/**
+ * The state the world stabilized at for one luminosity of a sweep
+ */
+template <typename Scalar = float>
+struct SweepPoint {
+    float luminosity;
+    // whether this point is on the rising or falling part of the sweep
+    bool rising;
+    Scalar proportion[World::COLORS];
+    Scalar temperature;
+    // the leading eigenvalue of the growth Jacobian and the recovery time, if the sweep analyzed stability
+    double leadingEigenvalue = std::numeric_limits<double>::quiet_NaN();
+    double recoveryTime = std::numeric_limits<double>::quiet_NaN();
+
+    /**
+     * Gets a value by the name of its data file column
+     * @param column One of "a_w", "a_b", "a_g", or "temp"
+     */
+    Scalar Column(const std::string& column) const {
+        if (column == "a_w") return proportion[World::WHITE];
+        if (column == "a_b") return proportion[World::BLACK];
+        if (column == "a_g") return proportion[World::GRAY];
+        return temperature;
+    }
+};
+
+/**
+ * Run the Update method on a world updates times
+ * @param world The world
+ * @param updates How many times to call the update function
+ * @param events If given, watches the world after every update for extinctions, recoveries, and temperature excursions
+ */
+template <typename Scalar>
+void UpdateWorldTimes(DaisyWorld<Scalar>& world, int updates, EventDetector* events = nullptr) {
+    if (!events && updates > 0) {
+        // nothing watches the individual updates, so each half runs in one fused loop
+        world.UpdateN(updates / 2 + 1);
+        if (world.GetSeedingPolicy().seedHalfway) world.BoostDaisiesIfExtinct();
+        world.UpdateN(updates - updates / 2 - 1);
+        return;
+    }
+    for (int update = 0; update < updates; update++) {
+        world.Update();
+        if (events) events->Observe(world);
+        // boost the daisies halfway through to allow them to respond to other types of daisies growing
+        if (update == updates / 2 && world.GetSeedingPolicy().seedHalfway) world.BoostDaisiesIfExtinct();
+    }
+}
+
+/**
+ * Updates the world's luminosity, makes sure daisies are not extinct, and updates the world for updates steps
+ * @param world The world
+ * @param luminosity The dimensionless luminosity to test at
+ * @param updates Number of updates to run at this luminosity
+ * @param events If given, watches the world after every update for extinctions, recoveries, and temperature excursions
+ */
+template <typename Scalar>
+void TestWorldAtLuminosity(DaisyWorld<Scalar>& world, float luminosity, int updates, EventDetector* events = nullptr) {
+    world.SetSolarLuminosity(luminosity);
+    if (world.GetSeedingPolicy().seedOnLuminosityChange) world.BoostDaisiesIfExtinct();
+    UpdateWorldTimes(world, updates, events);
+}
+
+/**
+ * Records the current state of a world as a point of a sweep
+ * @param analyzeStability Whether to also find how stable the state is
+ */
+template <typename Scalar>
+SweepPoint<Scalar> RecordSweepPoint(DaisyWorld<Scalar>& world, bool rising, bool analyzeStability = false) {
+    SweepPoint<Scalar> point;
+    point.luminosity = ScalarValue(world.GetSolarLuminosity());
+    point.rising = rising;
+    point.proportion[World::WHITE] = world.GetProportionWhite();
+    point.proportion[World::BLACK] = world.GetProportionBlack();
+    point.proportion[World::GRAY] = world.GetProportionGray();
+    point.temperature = world.GetGlobalTemperature();
+    if (analyzeStability) {
+        StabilityResult stability = world.AnalyzeStability();
+        point.leadingEigenvalue = stability.leadingEigenvalueReal;
+        point.recoveryTime = stability.RecoveryTime();
+    }
+    return point;
+}
+
+/**
+ * Finds the steady state that a flat world with one color of daisy settles into from a cover, the way running it would.
+ * The cover only moves towards the nearest steady state in the direction it grows, and dies out once it falls below the
+ * extinction threshold. Just above a stable state the cover shrinks, and just above an unstable one it grows.
+ * @param states The steady states at the current luminosity, from the least cover to the most
+ * @param proportion The cover to start from
+ * @param extinctionThreshold The world's extinction threshold
+ */
+template <typename Scalar>
+const typename DaisyWorld<Scalar>::SteadyState& SettleSingleSpecies(const std::vector<typename DaisyWorld<Scalar>::SteadyState>& states, float proportion, float extinctionThreshold) {
+    size_t below = 0;
+    while (below + 1 < states.size() && ScalarValue(states[below + 1].proportion) <= proportion) below++;
+    if (ScalarValue(states[below].proportion) == proportion) return states[below];
+    if (!states[below].IsStable()) return states[below + 1];
+    return ScalarValue(states[below].proportion) < extinctionThreshold ? states[0] : states[below];
+}
+
+/**
+ * Runs the rising and falling luminosity sweep of a flat world with one color of daisy by solving for the steady state
+ * at each luminosity, so it takes microseconds rather than seconds. Apart from how long the world would take to settle
+ * near tipping points, the results match running the world, so they also serve as a reference for it.
+ * @param settings Which daisy is enabled and how the luminosity changes. SingleSpeciesColor must not be -1.
+ * @param configure Called on the new world before the sweep, to set its parameters
+ * @returns one point per luminosity, first the rising luminosities then the falling ones
+ */
+template <typename Scalar = float>
+std::vector<SweepPoint<Scalar>> RunAnalyticLuminositySweep(const SweepSettings& settings, const std::function<void(DaisyWorld<Scalar>&)>& configure = nullptr) {
+    using SteadyState = typename DaisyWorld<Scalar>::SteadyState;
+    int color = settings.SingleSpeciesColor();
+    DaisyWorld<Scalar> world(settings.whiteEnabled ? 0.33 : 0.0, settings.blackEnabled ? 0.33 : 0.0, settings.minLuminosity, settings.grayEnabled ? 0.33 : 0.0);
+    world.SetWhiteEnabled(settings.whiteEnabled);
+    world.SetBlackEnabled(settings.blackEnabled);
+    world.SetGrayEnabled(settings.grayEnabled);
+    if (configure) configure(world);
+    float seedAmount = settings.seeding.flatSeedAmount;
+    float proportion = ScalarValue(world.GetProportion(color));
+    int numberOfLuminosityTrials = settings.NumberOfLuminosityTrials();
+
+    std::vector<SweepPoint<Scalar>> points;
+    points.reserve(2 * numberOfLuminosityTrials + 1);
+    auto settle = [&](int trial, bool rising) {
+        world.SetSolarLuminosity(settings.minLuminosity + settings.luminosityStep * trial);
+        std::vector<SteadyState> states = world.FindSingleSpeciesSteadyStates(color);
+        // boost the daisies when the luminosity changes and halfway through, as TestWorldAtLuminosity does
+        if (settings.seeding.seedOnLuminosityChange) proportion = std::max(proportion, seedAmount);
+        SteadyState state = SettleSingleSpecies<Scalar>(states, proportion, world.GetExtinctionThreshold());
+        if (settings.seeding.seedHalfway && ScalarValue(state.proportion) < seedAmount) state = SettleSingleSpecies<Scalar>(states, seedAmount, world.GetExtinctionThreshold());
+        proportion = ScalarValue(state.proportion);
+
+        SweepPoint<Scalar> point;
+        point.luminosity = ScalarValue(world.GetSolarLuminosity());
+        point.rising = rising;
+        for (int i=0; i<World::COLORS; i++) point.proportion[i] = 0.0f;
+        point.proportion[color] = state.proportion;
+        point.temperature = state.temperature;
+        if (settings.analyzeStability) {
+            StabilityResult stability;
+            stability.leadingEigenvalueReal = state.eigenvalue;
+            point.leadingEigenvalue = state.eigenvalue;
+            point.recoveryTime = stability.RecoveryTime();
+        }
+        points.push_back(point);
+    };
+    for (int trial = 0; trial < numberOfLuminosityTrials; trial++) settle(trial, true);
+    for (int trial = numberOfLuminosityTrials; trial >= 0; trial--) settle(trial, false);
+    return points;
+}
+
+/**
+ * Runs the rising and falling luminosity test in memory rather than to a data file, recording the state the world
+ * stabilized at for each luminosity.
+ * @param settings Which daisies are enabled and how the luminosity changes
+ * @param configure Called on the new world before it runs, to set its parameters
+ * @param events If given, records the extinctions, recoveries, and temperature excursions during the sweep
+ * @param states If given, receives the state of the world at each point, to continue runs from
+ * @returns one point per luminosity, first the rising luminosities then the falling ones
+ */
+template <typename Scalar = float>
+std::vector<SweepPoint<Scalar>> RunLuminositySweep(const SweepSettings& settings, const std::function<void(DaisyWorld<Scalar>&)>& configure = nullptr, EventDetector* events = nullptr, std::vector<typename DaisyWorld<Scalar>::State>* states = nullptr) {
+    // events and states come from running the world, so the sweep cannot be solved for when they are wanted
+    if (settings.solveAnalytically && settings.SingleSpeciesColor() >= 0 && !events && !states) {
+        return RunAnalyticLuminositySweep<Scalar>(settings, configure);
+    }
+    // when all 3 are enabled, each starts with 0.33, matching the data file tests
+    DaisyWorld<Scalar> world(settings.whiteEnabled ? 0.33 : 0.0, settings.blackEnabled ? 0.33 : 0.0, settings.minLuminosity, settings.grayEnabled ? 0.33 : 0.0, settings.roundWorld);
+    world.SetWhiteEnabled(settings.whiteEnabled);
+    world.SetBlackEnabled(settings.blackEnabled);
+    world.SetGrayEnabled(settings.grayEnabled);
+    world.SetSeedingPolicy(settings.seeding);
+    if (configure) configure(world);
+    int updatesPerLuminosity = settings.timePerLuminosity * world.GetUpdatesPerTimeUnit();
+    int numberOfLuminosityTrials = settings.NumberOfLuminosityTrials();
+    if (events) events->Observe(world);
+
+    std::vector<SweepPoint<Scalar>> points;
+    points.reserve(2 * numberOfLuminosityTrials + 1);
+    // raise the luminosity from minLuminosity to maxLuminosity
+    for (int trial = 0; trial < numberOfLuminosityTrials; trial++) {
+        TestWorldAtLuminosity(world, settings.minLuminosity + settings.luminosityStep * trial, updatesPerLuminosity, events);
+        points.push_back(RecordSweepPoint(world, true, settings.analyzeStability));
+        if (states) states->push_back(world.SaveState());
+    }
+    // lower the luminosity from maxLuminosity to minLuminosity
+    for (int trial = numberOfLuminosityTrials; trial >= 0; trial--) {
+        TestWorldAtLuminosity(world, settings.minLuminosity + settings.luminosityStep * trial, updatesPerLuminosity, events);
+        points.push_back(RecordSweepPoint(world, false, settings.analyzeStability));
+        if (states) states->push_back(world.SaveState());
+    }
+    return points;
+}
+
+/**
+ * @returns how far a point of a sweep is from the line through two earlier points, by the largest difference in a
+ * proportion or in the weighted temperature. With only one earlier point, the line is flat.
+ */
+template <typename Scalar>
+float SweepPointError(const SweepPoint<Scalar>& point, const SweepPoint<Scalar>* beforeLast, const SweepPoint<Scalar>& last, float temperatureWeight) {
+    float fraction = 0.0;
+    if (beforeLast && beforeLast->luminosity != last.luminosity) {
+        fraction = (point.luminosity - last.luminosity) / (last.luminosity - beforeLast->luminosity);
+    }
+    auto distance = [&](float value, float beforeLastValue, float lastValue) {
+        float predicted = lastValue + (beforeLast ? fraction * (lastValue - beforeLastValue) : 0.0f);
+        return std::abs(value - predicted);
+    };
+    float error = temperatureWeight * distance(ScalarValue(point.temperature), beforeLast ? ScalarValue(beforeLast->temperature) : 0.0f, ScalarValue(last.temperature));
+    for (int i=0; i<World::COLORS; i++) {
+        error = std::max(error, distance(ScalarValue(point.proportion[i]), beforeLast ? ScalarValue(beforeLast->proportion[i]) : 0.0f, ScalarValue(last.proportion[i])));
+    }
+    return error;
+}
+
+/**
+ * Runs the rising and falling luminosity test with luminosity steps that adapt to the response of the world: fine steps
+ * where the state changes sharply or daisies go extinct or recover, and coarse steps where it barely changes.
+ * Rejected steps are rolled back to the state before them, so the history of the world is the same as in a uniform sweep
+ * through the accepted luminosities.
+ * @param settings Which daisies are enabled and how the luminosity changes. The luminosity step is the first step tried.
+ * @param adaptive How the steps are chosen
+ * @param plateausRun If given, receives how many luminosities the world was run at, including rejected steps
+ * @param configure Called on the new world before it runs, to set its parameters
+ * @param events If given, records the extinctions, recoveries, and temperature excursions of the accepted steps
+ * @returns one point per accepted luminosity, first the rising luminosities then the falling ones
+ */
+template <typename Scalar = float>
+std::vector<SweepPoint<Scalar>> RunAdaptiveLuminositySweep(const SweepSettings& settings, const AdaptiveStepSettings& adaptive, int* plateausRun = nullptr, const std::function<void(DaisyWorld<Scalar>&)>& configure = nullptr, EventDetector* events = nullptr) {
+    DaisyWorld<Scalar> world(settings.whiteEnabled ? 0.33 : 0.0, settings.blackEnabled ? 0.33 : 0.0, settings.minLuminosity, settings.grayEnabled ? 0.33 : 0.0, settings.roundWorld);
+    world.SetWhiteEnabled(settings.whiteEnabled);
+    world.SetBlackEnabled(settings.blackEnabled);
+    world.SetGrayEnabled(settings.grayEnabled);
+    world.SetSeedingPolicy(settings.seeding);
+    if (configure) configure(world);
+    int updatesPerLuminosity = settings.timePerLuminosity * world.GetUpdatesPerTimeUnit();
+    // extinctions and recoveries are needed to choose the steps even if the caller does not want them
+    EventDetector ownEvents;
+    if (!events) events = &ownEvents;
+    events->Observe(world);
+    int plateaus = 1;
+
+    std::vector<SweepPoint<Scalar>> points;
+    TestWorldAtLuminosity(world, settings.minLuminosity, updatesPerLuminosity, events);
+    points.push_back(RecordSweepPoint(world, true, settings.analyzeStability));
+    float step = settings.luminosityStep;
+    // rise to the maximum luminosity, then fall back to the minimum
+    for (bool rising : {true, false}) {
+        float target = rising ? settings.maxLuminosity : settings.minLuminosity;
+        float luminosity = points.back().luminosity;
+        // as in the uniform sweep, the maximum luminosity belongs to the falling part
+        if (!rising) points.back().rising = false;
+        while (std::abs(target - luminosity) > 0.5f * adaptive.minStep) {
+            float size = std::min(step, std::abs(target - luminosity));
+            float next = rising ? luminosity + size : luminosity - size;
+            typename DaisyWorld<Scalar>::State before = world.SaveState();
+            EventDetector eventsBefore = *events;
+            TestWorldAtLuminosity(world, next, updatesPerLuminosity, events);
+            plateaus++;
+            SweepPoint<Scalar> point = RecordSweepPoint(world, rising, settings.analyzeStability);
+            // the line runs through the previous two points of the same part of the sweep
+            const SweepPoint<Scalar>* beforeLast = points.size() >= 2 && points[points.size() - 2].rising == rising ? &points[points.size() - 2] : nullptr;
+            float error = SweepPointError(point, beforeLast, points.back(), adaptive.temperatureWeight);
+            // extinctions and recoveries that are undone within the step, like boosted daisies dying out again on a
+            // barren planet, do not count
+            bool eventHappened = false;
+            for (size_t i = eventsBefore.GetEvents().size(); i < events->GetEvents().size(); i++) {
+                const WorldEvent& event = events->GetEvents()[i];
+                if (event.type != WorldEvent::EXTINCTION && event.type != WorldEvent::RECOVERY) continue;
+                bool establishedBefore = ScalarValue(points.back().proportion[event.color]) > events->recoveryThreshold;
+                bool establishedAfter = ScalarValue(point.proportion[event.color]) > events->recoveryThreshold;
+                eventHappened = eventHappened || establishedBefore != establishedAfter;
+            }
+            if ((error > adaptive.errorTolerance || eventHappened) && size > adaptive.minStep * 1.001f) {
+                // too coarse here, so try again from the same state with a smaller step
+                world.RestoreState(before);
+                *events = eventsBefore;
+                step = std::max(0.5f * size, adaptive.minStep);
+                continue;
+            }
+            points.push_back(point);
+            luminosity = next;
+            if (error < 0.25f * adaptive.errorTolerance && !eventHappened) step = std::min(2.0f * size, adaptive.maxStep);
+        }
+    }
+    if (plateausRun) *plateausRun = plateaus;
+    return points;
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TIPPING_POINTS_H
+#define TIPPING_POINTS_H
+
+#include "Sweep.h"
+#include "Batch.h"
+#include <string>
+#include <vector>
+
+/**
+ * A luminosity where a color of daisy becomes established or collapses, on the rising or falling part of a sweep
+ */
+struct TippingPoint {
+    int color;
+    bool rising;
+    // whether the color becomes established, rather than collapsing, as the sweep passes this luminosity
+    bool appears;
+    // the critical luminosity, at the middle of the final bracket
+    float luminosity;
+    // the width of the final bracket, so the critical luminosity is within half of it
+    float uncertainty;
+
+    /**
+     * @returns a description of this tipping point, such as "white daisies collapse while rising"
+     */
+    std::string Describe() const {
+        static const std::string colorNames[World::COLORS] = {"white", "black", "gray"};
+        return colorNames[color] + " daisies " + (appears ? "appear" : "collapse") + " while " + (rising ? "rising" : "falling");
+    }
+};
+
+/**
+ * Describes how to find tipping points: a coarse sweep to bracket them, then bisection to narrow each bracket
+ */
+struct TippingPointSettings {
+    // the coarse sweep, whose luminosity step sets the width of the first brackets
+    SweepSettings sweep;
+    // how narrow to make each bracket
+    float tolerance = 0.0001;
+    // a color is established if it covers more than this proportion of the planet
+    float establishedThreshold = 0.01;
+};
+
+/**
+ * Finds the luminosities where each color of daisy appears or collapses, on both parts of the sweep. A coarse sweep
+ * brackets every change in which colors are established, and each bracket is then bisected in parallel. Every run
+ * during bisection continues from the state cached on the side of the bracket the sweep comes from, so it stays on the
+ * same branch of the hysteresis loop as a fine sweep would, and moves forward whenever the midpoint is on that side.
+ * @returns the tipping points in the order the sweep passes them
+ */
+inline std::vector<TippingPoint> LocateTippingPoints(const TippingPointSettings& settings) {
+    std::vector<World::State> states;
+    std::vector<SweepPoint<float>> points = RunLuminositySweep<float>(settings.sweep, nullptr, nullptr, &states);
+
+    // bracket each change between consecutive points of the same part of the sweep
+    std::vector<TippingPoint> tippingPoints;
+    std::vector<int> bracketStarts;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        if (points[i].rising != points[i + 1].rising) continue;
+        for (int color = 0; color < World::COLORS; color++) {
+            bool establishedBefore = points[i].proportion[color] > settings.establishedThreshold;
+            bool establishedAfter = points[i + 1].proportion[color] > settings.establishedThreshold;
+            if (establishedBefore == establishedAfter) continue;
+            tippingPoints.push_back({color, points[i].rising, establishedAfter, 0.0f, 0.0f});
+            bracketStarts.push_back(i);
+        }
+    }
+
+    RunBatch(tippingPoints.size(), [&](int job) {
+        TippingPoint& tippingPoint = tippingPoints[job];
+        int start = bracketStarts[job];
+        const SweepSettings& sweep = settings.sweep;
+        World world(0.0, 0.0, points[start].luminosity, 0.0, sweep.roundWorld);
+        world.SetWhiteEnabled(sweep.whiteEnabled);
+        world.SetBlackEnabled(sweep.blackEnabled);
+        world.SetGrayEnabled(sweep.grayEnabled);
+        world.SetSeedingPolicy(sweep.seeding);
+        int updatesPerLuminosity = sweep.timePerLuminosity * world.GetUpdatesPerTimeUnit();
+
+        // near is the side of the bracket the sweep comes from, and far the side where the color has changed
+        float near = points[start].luminosity;
+        float far = points[start + 1].luminosity;
+        World::State nearState = states[start];
+        while (std::abs(far - near) > settings.tolerance) {
+            float middle = 0.5f * (near + far);
+            world.RestoreState(nearState);
+            TestWorldAtLuminosity(world, middle, updatesPerLuminosity);
+            bool established = world.GetProportion(tippingPoint.color) > settings.establishedThreshold;
+            if (established == tippingPoint.appears) {
+                far = middle;
+            } else {
+                near = middle;
+                nearState = world.SaveState();
+            }
+        }
+        tippingPoint.luminosity = 0.5f * (near + far);
+        tippingPoint.uncertainty = std::abs(far - near);
+    });
+    return tippingPoints;
+}
+
+#endif
@@ -5,14 +5,29 @@
 #include "emp/math/random_utils.hpp"
 #include "emp/math/Random.hpp"
 #include "emp/data/DataFile.hpp"
+#include "Dual.h"
+#include "SeedingPolicy.h"
+#include "Stability.h"
+#include "Summation.h"
+#include "Precision.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <string>
+#include <utility>
+#include <vector>
 
 /**
  * The Daisyworld system, which updates the amount of white and black daisies
  * based on temperature. There are no agents in the world, rather, it inherits from
  * Empirical's world to have access to data files.
+ * @tparam Scalar The number type the model is computed in. float for ordinary runs, or a Dual number to also
+ * compute derivatives of the results with respect to the model's parameters.
  */
-class World : emp::World<float> {
+template <typename Scalar = float>
+class DaisyWorld : emp::World<float> {
 
     /**
      * Holds the amount of white, black, and gray daisies on the ground
@@ -22,9 +37,9 @@ class World : emp::World<float> {
          * The proportion of ground that is covered by the different kinds of daisies
          * proportion[0] = white, proportion[1] = black, proportion[2] = gray
          */
-        float proportion[3];
+        Scalar proportion[3];
 
-        GroundCover(float _proportionWhite = 0.33, float _proportionBlack = 0.33, float _proportionGray = 0.0) {
+        GroundCover(Scalar _proportionWhite = 0.33f, Scalar _proportionBlack = 0.33f, Scalar _proportionGray = 0.0f) {
             proportion[WHITE] = _proportionWhite;
             proportion[BLACK] = _proportionBlack;
             proportion[GRAY] = _proportionGray;
@@ -33,9 +48,9 @@ class World : emp::World<float> {
         /**
          * @returns the proportion of the planet that is not covered by daisies
          */
-        float GetProportionGround() {
+        Scalar GetProportionGround() {
             // equation (2) of Daisyworld paper
-            float total = 1.0;
+            Scalar total = 1.0f;
             for (int i=0; i<COLORS; i++) {
                 total -= proportion[i];
             }
@@ -45,24 +60,28 @@ class World : emp::World<float> {
         /**
          * Gets the proportion of the number of daisies of this existent color, otherwise gets bare ground coverage
          */
-        float Proportion(int color) {
+        Scalar Proportion(int color) {
             return (color < 0 || color >= COLORS) ? GetProportionGround() : proportion[color];
         }
 
         /**
          * Increments the color by delta, keeping it clamped below at 0
+         * @param extinctionThreshold The color dies out if it falls below this
          */
-        void IncrementColor(int color, float delta) {
-            proportion[color] += delta;
-            // clamp values below at 0, don't allow tiny amounts of daisies
-            if (proportion[color] < 0.001) proportion[color] = 0.0;
+        void IncrementColor(int color, Scalar delta, float extinctionThreshold = 0.001f) {
+            Scalar incremented = proportion[color] + delta;
+            // clamp values below at 0, don't allow tiny amounts of daisies. Selecting rather than branching lets the
+            // clamp compile to a compare and mask.
+            proportion[color] = incremented < extinctionThreshold ? Scalar(0.0f) : incremented;
         }
 
         /**
          * @returns a weighted average of the albedos of the different types of flowers
+         * @param flowerAlbedos The albedo of each color of flower
+         * @param groundAlbedo The albedo of bare ground
          */
-        float GetTotalAlbedo() {
-            float total = GetProportionGround() * groundAlbedo;
+        Scalar GetTotalAlbedo(const Scalar (&flowerAlbedos)[3], const Scalar& groundAlbedo) {
+            Scalar total = GetProportionGround() * groundAlbedo;
             for (int i=0; i<COLORS; i++) {
                 total += proportion[i] * flowerAlbedos[i];
             }
@@ -82,7 +101,7 @@ class World : emp::World<float> {
     bool roundWorld = false;
     
     // dimensionless scaling factor for solar luminosity
-    float solarLuminosity = 1.0;
+    Scalar solarLuminosity = 1.0f;
 
     // whether each type of daisy is allowed to exist
     bool enabledColors[3] = {true, true, false};
@@ -90,16 +109,22 @@ class World : emp::World<float> {
     // whether daisies can grow or die
     bool daisiesCanGrowAndDie = true;
 
+    // carries out the policy for reseeding daisies that have died out
+    Seeder seeder;
+
+    // the stability calculated for the most recent data file record
+    StabilityResult lastStability;
+
     emp::DataMonitor<float>* temperatureMonitor;
 
     // the global temperature and albedo, cached until the proportion of daisies or luminosity changes
     // if no applicable value, set to nan
-    float cachedGlobalTemperature = std::numeric_limits<float>::quiet_NaN();
-    float cachedGlobalAlbedo = std::numeric_limits<float>::quiet_NaN();
+    Scalar cachedGlobalTemperature = std::numeric_limits<float>::quiet_NaN();
+    Scalar cachedGlobalAlbedo = std::numeric_limits<float>::quiet_NaN();
 
     // the albedos of the different colored flowers
-    static constexpr float flowerAlbedos[3] = {0.75, 0.25, 0.5};
-    static constexpr float groundAlbedo = 0.5;
+    Scalar flowerAlbedos[3] = {0.75f, 0.25f, 0.5f};
+    Scalar groundAlbedo = 0.5f;
     
     // stefan's constant in units of ergs / (second * cm^2 * K^4)
     const float stefansConstant = 0.0000567;
@@ -111,10 +136,24 @@ class World : emp::World<float> {
     const float celsiusToKelvin = 273;
 
     // the degree to which solar intensity is distributed between different surfaces
-    const float conductivityConstant = 20;
+    Scalar conductivityConstant = 20.0f;
 
     // the death rate of daisies per time
-    const float deathRate = 0.3;
+    Scalar deathRate = 0.3f;
+
+    // on a round world, of the temperature conducting to a patch of flowers from elsewhere on the planet, the proportion
+    // that comes from its own latitude rather than from the global temperature
+    float latitudinalConduction = 0.0f;
+
+    // how the sums over the latitudes of a round planet are added up
+    Summation summation = Summation::PAIRWISE;
+
+    // a color dies out wherever its proportion falls below this. Above 0, this also keeps proportions from decaying
+    // into subnormal floats, which are many times slower to compute with.
+    float extinctionThreshold = 0.001f;
+
+    // on a flat planet, how much each color grew in the last update before the extinction threshold was applied
+    Scalar lastGrowthAmounts[3] = {};
 
     // how much time is incremented each time Update is called
     const float timePerUpdate = 0.01;
@@ -151,15 +190,59 @@ class World : emp::World<float> {
      * Initializes a starting solar luminosity and flower populations.
      * @param _roundWorld Whether to compute different temperatures at different latitudes of the planet
      */
-    World(float _proportionWhite, float _proportionBlack, float _solarLuminosity, float _proportionGray = 0.0f, bool _roundWorld = false)
+    DaisyWorld(float _proportionWhite, float _proportionBlack, Scalar _solarLuminosity, float _proportionGray = 0.0f, bool _roundWorld = false)
         : ground(_proportionWhite, _proportionBlack, _proportionGray), solarLuminosity(_solarLuminosity), roundWorld(_roundWorld) {
         for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
             groundAtLatitudes[latitude] = GroundCover(_proportionWhite, _proportionBlack, _proportionGray);
+            latitudeContext.insolation[latitude] = GetLuminosityMultiplierAtLatitude(latitude);
         }
         daisiesCanGrowAndDie = true;
         update = 0;
     }
 
+    /**
+     * The energy the planet absorbs from the sun and emits as longwave radiation (sigma T^4), in W/m^2 per unit of
+     * surface, averaged over the updates since the budget was last taken, or of the current state before any update.
+     * Daisyworld sets the global temperature so the two balance, so a global imbalance beyond rounding means the model
+     * is losing or creating energy, and the imbalance of each band is the heat the model moves out of it.
+     */
+    struct EnergyBudget {
+        double absorbed = 0.0;
+        double emitted = 0.0;
+        // on a round world, the same for each displayed latitude band, from 0 (equatorial) to 9 (polar)
+        double bandAbsorbed[numberOfDisplayedLatitudes] = {};
+        double bandEmitted[numberOfDisplayedLatitudes] = {};
+        // how many updates were averaged, or 0 for the budget of a single state
+        int updates = 0;
+
+        /**
+         * Adds the budget of one more update to these totals
+         */
+        void AddUpdate(const EnergyBudget& step) {
+            absorbed += step.absorbed;
+            emitted += step.emitted;
+            for (int band = 0; band < numberOfDisplayedLatitudes; band++) {
+                bandAbsorbed[band] += step.bandAbsorbed[band];
+                bandEmitted[band] += step.bandEmitted[band];
+            }
+            updates++;
+        }
+
+        /**
+         * @returns the net energy gained, absorbed minus emitted
+         */
+        double Imbalance() const {
+            return absorbed - emitted;
+        }
+
+        /**
+         * @returns the net energy gained by a displayed latitude band
+         */
+        double BandImbalance(int band) const {
+            return bandAbsorbed[band] - bandEmitted[band];
+        }
+    };
+
     private:
 
     /**
@@ -167,6 +250,170 @@ class World : emp::World<float> {
      */
     GroundCover groundAtLatitudes[numberOfLatitudes] = {};
 
+    /**
+     * What the growth rates at every latitude of a round planet share during one update, computed once at the start
+     * of the update rather than for every color at every latitude
+     */
+    struct LatitudeContext {
+        Scalar globalAlbedo;
+        Scalar globalTemperature;
+        // the proportion of bare ground at each latitude
+        Scalar bareGround[numberOfLatitudes];
+        // the luminosity multiplier of each latitude, which never changes
+        float insolation[numberOfLatitudes];
+        // the proportion of the sunlight reaching the planet that each latitude absorbs, before averaging
+        Scalar absorbed[numberOfLatitudes];
+        // with latitudinal conduction, the temperature conducting to the flowers at each latitude, mixing the
+        // temperature of the latitude with the global temperature
+        Scalar conductingTemperature[numberOfLatitudes];
+        // the run of latitudes from the most polar to the most equatorial where any enabled color grows, widened by one
+        // latitude on each side when daisies disperse. Growth is exactly zero outside of it, so the update skips those
+        // latitudes until seeding or a boost revives them.
+        int firstActiveLatitude;
+        int endActiveLatitude;
+    };
+
+    LatitudeContext latitudeContext;
+
+    /**
+     * Where one color of daisy grows on a round planet, kept so the habitat edges and mean latitude written to data
+     * files each update don't need another pass over the latitudes
+     */
+    struct Habitat {
+        static constexpr int WORDS = (numberOfLatitudes + 63) / 64;
+        // bit l of word l / 64 is set where latitude l has any cover of the color
+        uint64_t occupied[WORDS];
+        // the cover summed over the latitudes, and weighted by latitude
+        float proportion;
+        float latitudeProportion;
+
+        void Clear() {
+            std::fill(occupied, occupied + WORDS, 0);
+            proportion = 0.0;
+            latitudeProportion = 0.0;
+        }
+
+        void Add(int latitude, float cover) {
+            occupied[latitude / 64] |= (uint64_t)(cover > 0.0) << (latitude % 64);
+            proportion += cover;
+            latitudeProportion += latitude * cover;
+        }
+
+        /**
+         * @returns the lowest occupied latitude, or numberOfLatitudes if there is none
+         */
+        int First() const {
+            for (int word = 0; word < WORDS; word++) {
+                if (occupied[word]) return word * 64 + __builtin_ctzll(occupied[word]);
+            }
+            return numberOfLatitudes;
+        }
+
+        /**
+         * @returns the highest occupied latitude, or -1 if there is none
+         */
+        int Last() const {
+            for (int word = WORDS - 1; word >= 0; word--) {
+                if (occupied[word]) return word * 64 + 63 - __builtin_clzll(occupied[word]);
+            }
+            return -1;
+        }
+    };
+
+    Habitat habitats[COLORS];
+
+    // whether the habitats match the current cover. Round updates keep them current while data files are being
+    // written, and anything else that changes the cover clears this with the cached values.
+    bool habitatsCurrent = false;
+
+    /**
+     * @returns the habitat of a color, recounting every habitat first if they are out of date
+     */
+    const Habitat& GetHabitat(int color) {
+        if (!habitatsCurrent) {
+            for (int i=0; i<COLORS; i++) habitats[i].Clear();
+            for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
+                for (int i=0; i<COLORS; i++) habitats[i].Add(latitude, ScalarValue(groundAtLatitudes[latitude].proportion[i]));
+            }
+            habitatsCurrent = true;
+        }
+        return habitats[color];
+    }
+
+    // whether the update kernels add each update to the energy budget, which data files turn on when they record it
+    bool trackingEnergyBudget = false;
+
+    // the energy budget summed over the updates since it was last taken
+    EnergyBudget energyBudgetTotals;
+
+    // the energy budget taken for the most recent data file record
+    EnergyBudget lastEnergyBudget;
+
+    /**
+     * @returns the longwave radiation in W/m^2 emitted at a temperature in Celsius
+     */
+    double EmittedAt(double temperature) {
+        double kelvin = temperature + celsiusToKelvin;
+        // stefansConstant is in ergs / (second * cm^2 * K^4), and 1 erg / (second * cm^2) is 0.001 W/m^2
+        return 0.001 * stefansConstant * (kelvin * kelvin) * (kelvin * kelvin);
+    }
+
+    /**
+     * Adds the energy budget of a flat planet to a budget
+     */
+    void AddToEnergyBudget(EnergyBudget& budget, Scalar globalAlbedo, Scalar globalTemperature) {
+        budget.absorbed += 0.001 * fluxConstant * ScalarValue(solarLuminosity * (1 - globalAlbedo));
+        budget.emitted += EmittedAt(ScalarValue(globalTemperature));
+    }
+
+    /**
+     * Adds the energy budget of a round planet to a budget. Each latitude emits at the temperature conducting to its
+     * flowers, which is the global temperature without latitudinal conduction.
+     * @param absorbed The proportion of the sunlight reaching the planet that each latitude absorbs, as in the latitude
+     * context
+     * @param conductingTemperature The temperature conducting to the flowers at each latitude, or nullptr without
+     * latitudinal conduction
+     */
+    void AddToEnergyBudgetOnRoundPlanet(EnergyBudget& budget, const Scalar* absorbed, const Scalar* conductingTemperature, Scalar globalTemperature) {
+        constexpr int latitudesPerBand = numberOfLatitudes / numberOfDisplayedLatitudes;
+        double sunlight = 0.001 * fluxConstant * ScalarValue(solarLuminosity);
+        double globalEmitted = EmittedAt(ScalarValue(globalTemperature));
+        for (int band = 0; band < numberOfDisplayedLatitudes; band++) {
+            double bandAbsorbed = 0.0, bandEmitted = 0.0;
+            // band 0 is at the equator, the end of the internal latitudes
+            for (int latitude = numberOfLatitudes - latitudesPerBand * (band + 1); latitude < numberOfLatitudes - latitudesPerBand * band; latitude++) {
+                bandAbsorbed += sunlight * ScalarValue(absorbed[latitude]);
+                bandEmitted += conductingTemperature ? EmittedAt(ScalarValue(conductingTemperature[latitude])) : globalEmitted;
+            }
+            budget.bandAbsorbed[band] += bandAbsorbed / latitudesPerBand;
+            budget.bandEmitted[band] += bandEmitted / latitudesPerBand;
+            budget.absorbed += bandAbsorbed / numberOfLatitudes;
+            budget.emitted += bandEmitted / numberOfLatitudes;
+        }
+    }
+
+    /**
+     * @returns the energy budget of the current state of the world, for records taken before any update was added
+     * up and for updates that don't change the cover
+     */
+    EnergyBudget CurrentEnergyBudget() {
+        EnergyBudget budget;
+        Scalar globalTemperature = GetGlobalTemperature();
+        if (!roundWorld) {
+            AddToEnergyBudget(budget, GetTotalAlbedo(), globalTemperature);
+            return budget;
+        }
+        // the same sunlight and temperatures as PrepareLatitudeContext
+        Scalar absorbed[numberOfLatitudes];
+        Scalar conductingTemperature[numberOfLatitudes];
+        for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
+            absorbed[latitude] = latitudeContext.insolation[latitude] * (1 - groundAtLatitudes[latitude].GetTotalAlbedo(flowerAlbedos, groundAlbedo));
+            conductingTemperature[latitude] = latitudinalConduction * TemperatureOfInternalLatitude(latitude) + (1 - latitudinalConduction) * globalTemperature;
+        }
+        AddToEnergyBudgetOnRoundPlanet(budget, absorbed, latitudinalConduction != 0.0f ? conductingTemperature : nullptr, globalTemperature);
+        return budget;
+    }
+
     // how luminosity changes over different latitudes on a round planet
     const float minLuminosityMultiplier = 0.6;
     const float maxLuminosityMultiplier = 1.5;
@@ -185,15 +432,15 @@ class World : emp::World<float> {
      * @returns The amount of sunlight that is reflected overall on a round planet, where absorbsions on higher latitudes
      * with less sunlight are weighted less
      */
-    float GetAverageAlbedoOnRoundPlanet() {
-        float totalGlobalAbsorbsion = 0.0;
+    Scalar GetAverageAlbedoOnRoundPlanet() {
+        Scalar absorbsions[numberOfLatitudes];
         for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
             GroundCover groundAtLatitude = groundAtLatitudes[latitude];
-            float AlbedoAtLatitude = groundAtLatitude.GetTotalAlbedo();
-            float AbsorbsionAtLatitude = 1 - AlbedoAtLatitude;
-            totalGlobalAbsorbsion += GetLuminosityMultiplierAtLatitude(latitude) * AbsorbsionAtLatitude / numberOfLatitudes;
+            Scalar AlbedoAtLatitude = groundAtLatitude.GetTotalAlbedo(flowerAlbedos, groundAlbedo);
+            Scalar AbsorbsionAtLatitude = 1 - AlbedoAtLatitude;
+            absorbsions[latitude] = GetLuminosityMultiplierAtLatitude(latitude) * AbsorbsionAtLatitude;
         }
-        return 1 - totalGlobalAbsorbsion;
+        return 1 - Sum(absorbsions, numberOfLatitudes, summation) / numberOfLatitudes;
     }
 
     /**
@@ -202,14 +449,16 @@ class World : emp::World<float> {
      * @param aggregateLatitude -1 if getting the proportion over entire world. Otherwise, the average number of this color
      * in this band of latitudes.
      */
-    float Proportion(int color, int aggregateLatitude) {
+    Scalar Proportion(int color, int aggregateLatitude) {
         if (roundWorld) {
-            float totalProportion = 0.0;
+            Scalar totalProportion = 0.0f;
             if (aggregateLatitude < 0) {
                 // aggregate over entire planet
+                Scalar proportions[numberOfLatitudes];
                 for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
-                    totalProportion += groundAtLatitudes[latitude].Proportion(color) / numberOfLatitudes;
+                    proportions[latitude] = groundAtLatitudes[latitude].Proportion(color);
                 }
+                totalProportion = Sum(proportions, numberOfLatitudes, summation) / numberOfLatitudes;
             } else {
                 // aggregate over a certain band of latitudes of the planet
                 int displayBandWidth = numberOfLatitudes / numberOfDisplayedLatitudes;
@@ -242,9 +491,10 @@ class World : emp::World<float> {
 
     /**
      * @param localTemperature The local temperature over this type of flower
-     * @returns the growth rate per unit time on bare ground of this type of daisy
+     * @returns the growth rate per unit time on bare ground of this type of daisy, in the number type of the temperature
      */
-    float GrowthRateFunction(float localTemperature) {
+    template <typename T>
+    T GrowthRateFunction(T localTemperature) {
         // equation (3) from Daisyworld paper
         return 1 - 0.003265 * (22.5 - localTemperature) * (22.5 - localTemperature);
     }
@@ -253,11 +503,42 @@ class World : emp::World<float> {
      * Calculates the rate of change of amount of daisies of a color on a flat planet.
      * @param color The color of these daisies
      */
-    float GrowthRate(int color) {
+    Scalar GrowthRate(int color) {
+        return GrowthRate(color, GetTotalAlbedo(), GetGlobalTemperature());
+    }
+
+    /**
+     * Calculates the rate of change of amount of daisies of a color on a flat planet, given the current global albedo
+     * and temperature
+     * @param color The color of these daisies
+     */
+    Scalar GrowthRate(int color, Scalar globalAlbedo, Scalar globalTemperature) {
         // equation (1) from Daisyworld paper
-        float proportionOfColor = ground.proportion[color];
-        float localTemperature = LocalTemperature(color);
-        return proportionOfColor * (GrowthRateFunction(localTemperature) * GetProportionGround() - deathRate);
+        Scalar proportionOfColor = ground.proportion[color];
+        Scalar localTemperature = LocalTemperature(color, globalAlbedo, globalTemperature);
+        return proportionOfColor * (GrowthRateFunction(localTemperature) * ground.GetProportionGround() - deathRate);
+    }
+
+    /**
+     * On a flat planet where only one color of daisy grows, the growth rate of that color per unit of its cover, from
+     * equation (1). It is 0 at the steady states where the color covers some of the planet.
+     * @param color The color of these daisies
+     * @param proportionOfColor The proportion of the planet they cover, assuming no other daisies
+     * @param slope Receives the derivative of the growth rate with respect to the proportion
+     */
+    Scalar SingleSpeciesGrowthRatePerCover(int color, Scalar proportionOfColor, Scalar& slope) {
+        Scalar albedoDifference = flowerAlbedos[color] - groundAlbedo;
+        Scalar globalAlbedo = groundAlbedo + proportionOfColor * albedoDifference;
+        Scalar globalTemperature = GlobalTemperatureFor(globalAlbedo, solarLuminosity);
+        // equation (7) of Daisyworld
+        Scalar localTemperature = conductivityConstant * (globalAlbedo - flowerAlbedos[color]) + globalTemperature;
+        Scalar bareGround = 1 - proportionOfColor;
+        Scalar growthFunction = GrowthRateFunction(localTemperature);
+        // the local temperature depends on the cover directly, and through the global temperature from equation (4)
+        Scalar localTemperatureSlope = albedoDifference * (conductivityConstant - (globalTemperature + celsiusToKelvin) / (4 * (1 - globalAlbedo)));
+        Scalar growthFunctionSlope = 2 * 0.003265 * (22.5 - localTemperature);
+        slope = growthFunctionSlope * localTemperatureSlope * bareGround - growthFunction;
+        return growthFunction * bareGround - deathRate;
     }
 
     /**
@@ -266,11 +547,12 @@ class World : emp::World<float> {
      * @param latitude The latitude on the planet, ranging from 0 (polar) to 99 (equitorial)
      * @returns the growth rate of daisies of this color per unit time
      */
-    float GrowthRateAtLatitude(int color, int latitude) {
+    template <bool conducting>
+    Scalar GrowthRateAtLatitude(int color, int latitude, const LatitudeContext& context) {
         // equation (1) from Daisyworld paper
-        float proportionOfColor = groundAtLatitudes[latitude].proportion[color];
-        float localTemperature = LocalTemperatureAtLatitude(color, latitude);
-        return proportionOfColor * (GrowthRateFunction(localTemperature) * groundAtLatitudes[latitude].GetProportionGround() - deathRate);
+        Scalar proportionOfColor = groundAtLatitudes[latitude].proportion[color];
+        Scalar localTemperature = LocalTemperatureAtLatitude<conducting>(color, latitude, context);
+        return proportionOfColor * (GrowthRateFunction(localTemperature) * context.bareGround[latitude] - deathRate);
     }
 
     /**
@@ -278,42 +560,67 @@ class World : emp::World<float> {
      * @param color The color of the flowers
      * @returns the local temperature over areas with flowers of that color, based on global temperature
      */
-    float LocalTemperature(int color) {
+    Scalar LocalTemperature(int color) {
+        return LocalTemperature(color, GetTotalAlbedo(), GetGlobalTemperature());
+    }
+
+    /**
+     * Gets the local temperature of the flowers of a color, given the current global albedo and temperature
+     */
+    Scalar LocalTemperature(int color, Scalar globalAlbedo, Scalar globalTemperature) {
         // equation (7) of Daisyworld
-        float localAlbedo = flowerAlbedos[color];
-        return conductivityConstant * (GetTotalAlbedo() - localAlbedo) + GetGlobalTemperature();
+        Scalar localAlbedo = flowerAlbedos[color];
+        return conductivityConstant * (globalAlbedo - localAlbedo) + globalTemperature;
     }
 
     /**
      * Calculates the local temperature of the flowers depending on global temperatue, their albedo, and the latitude of this patch of flowers
      * @param color The color of the local flowers
      * @param latitude The latitude on the planet, ranging from 0 (polar) to 99 (equitorial)
-     * @param latitudinalConduction Of the temperature influence conducting from elsewhere on the planet, what proportion comes
-     * from the latitudinal temperature?
      * @returns the local temperature over areas with flowers of that color
      */
-    float LocalTemperatureAtLatitude(int color, int latitude, float latitudinalConduction = 0.0) {
+    Scalar LocalTemperatureAtLatitude(int color, int latitude) {
         // based on equation (7) of Daisyworld, adapted to a planet with multiple latitudes and thus multiple solar luminosities
-        float globalAlbedo = GetTotalAlbedo();
-        float globalTemperature = GetGlobalTemperature();
-        float globalAbsorbtivity = 1 - globalAlbedo;
-        float localAlbedo = flowerAlbedos[color];
-        float localAbsorbtivity = 1 - localAlbedo;
-        float scaledLocalAbsorbtivity = localAbsorbtivity * GetLuminosityMultiplierAtLatitude(latitude);
-        float conductingTemperature = latitudinalConduction == 0.0 ? globalTemperature : latitudinalConduction * TemperatureOfInternalLatitude(latitude) + (1 - latitudinalConduction) * globalTemperature;
+        Scalar globalAlbedo = GetTotalAlbedo();
+        Scalar globalTemperature = GetGlobalTemperature();
+        Scalar globalAbsorbtivity = 1 - globalAlbedo;
+        Scalar localAlbedo = flowerAlbedos[color];
+        Scalar localAbsorbtivity = 1 - localAlbedo;
+        Scalar scaledLocalAbsorbtivity = localAbsorbtivity * GetLuminosityMultiplierAtLatitude(latitude);
+        Scalar conductingTemperature = latitudinalConduction == 0.0 ? globalTemperature : latitudinalConduction * TemperatureOfInternalLatitude(latitude) + (1 - latitudinalConduction) * globalTemperature;
+        return conductivityConstant * (scaledLocalAbsorbtivity - globalAbsorbtivity) + conductingTemperature;
+    }
+
+    /**
+     * Calculates the local temperature of the flowers of a color at a latitude from the context of this update
+     * @tparam conducting Whether latitudinal conduction is on, so the context has the conducting temperatures
+     */
+    template <bool conducting>
+    Scalar LocalTemperatureAtLatitude(int color, int latitude, const LatitudeContext& context) {
+        Scalar globalAbsorbtivity = 1 - context.globalAlbedo;
+        Scalar localAbsorbtivity = 1 - flowerAlbedos[color];
+        Scalar scaledLocalAbsorbtivity = localAbsorbtivity * context.insolation[latitude];
+        Scalar conductingTemperature = conducting ? context.conductingTemperature[latitude] : context.globalTemperature;
         return conductivityConstant * (scaledLocalAbsorbtivity - globalAbsorbtivity) + conductingTemperature;
     }
 
     /**
      * Calculates the average temperature across daisy types at this latitude
      */
-    float TemperatureOfInternalLatitude(int internalLatitude) {
+    Scalar TemperatureOfInternalLatitude(int internalLatitude) {
         // based on equation (4) of Daisyworld
-        float latitudinalAlbedo = groundAtLatitudes[internalLatitude].GetTotalAlbedo();
-        float latitudalAbsorbtivity = 1 - latitudalAbsorbtivity;
-        int latitudesPerBand = numberOfLatitudes / numberOfDisplayedLatitudes;
-        float scaledLatitudalAbsorbtivity = latitudalAbsorbtivity * GetLuminosityMultiplierAtLatitude(internalLatitude);
-        return std::pow((fluxConstant * solarLuminosity * scaledLatitudalAbsorbtivity) / stefansConstant, 0.25) - celsiusToKelvin;
+        Scalar latitudinalAlbedo = groundAtLatitudes[internalLatitude].GetTotalAlbedo(flowerAlbedos, groundAlbedo);
+        Scalar latitudalAbsorbtivity = 1 - latitudinalAlbedo;
+        Scalar scaledLatitudalAbsorbtivity = latitudalAbsorbtivity * GetLuminosityMultiplierAtLatitude(internalLatitude);
+        return FourthRoot((fluxConstant * solarLuminosity * scaledLatitudalAbsorbtivity) / stefansConstant) - celsiusToKelvin;
+    }
+
+    /**
+     * Takes the fourth root with two square roots, which unlike pow can be vectorized over the latitudes
+     */
+    static Scalar FourthRoot(Scalar x) {
+        using std::sqrt;
+        return sqrt(sqrt(x));
     }
 
     /**
@@ -322,55 +629,154 @@ class World : emp::World<float> {
     void ClearCachedValues() {
         cachedGlobalTemperature = std::numeric_limits<float>::quiet_NaN();
         cachedGlobalAlbedo = std::numeric_limits<float>::quiet_NaN();
+        habitatsCurrent = false;
     }
 
     /**
-     * Does one time step, letting daisies grow and die according to the local temperature
+     * @returns whether a color of daisy is enabled in an update kernel configuration
      */
-    void UpdateDaisyAmountsOnFlatPlanet() {
+    static constexpr bool KernelHasColor(int configuration, int color) {
+        return (configuration & (1 << color)) != 0;
+    }
+
+    /**
+     * Does one time step on a flat planet from the global albedo and temperature at the start of the step, without
+     * touching the cached values
+     * @tparam configuration Which colors are enabled, as in GetKernelConfiguration
+     */
+    template <int configuration>
+    void GrowDaisiesOnFlatPlanet(Scalar globalAlbedo, Scalar globalTemperature) {
         // the amount that each type of daisy grows this update
-        float growthAmounts[COLORS];
+        Scalar growthAmounts[COLORS];
         for (int i=0; i<COLORS; i++) {
-            growthAmounts[i] = GrowthRate(i) * timePerUpdate;
+            if (KernelHasColor(configuration, i)) growthAmounts[i] = GrowthRate(i, globalAlbedo, globalTemperature) * timePerUpdate;
+            lastGrowthAmounts[i] = KernelHasColor(configuration, i) ? growthAmounts[i] : Scalar(0.0f);
         }
+        bool seeding = seeder.BeginStep();
         // update the amounts of each type of daisy if they are enabled
         for (int i=0; i<COLORS; i++) {
-            if (enabledColors[i]) ground.IncrementColor(i, growthAmounts[i]);
+            if (KernelHasColor(configuration, i)) ground.IncrementColor(i, growthAmounts[i], extinctionThreshold);
         }
-        ClearCachedValues();
+        if (seeding) seeder.SeedCover(ground.proportion, enabledColors, seeder.GetPolicy().flatSeedAmount);
+        if (seeder.TracksExtinctions()) seeder.EndStep(ground.proportion);
     }
 
     /**
-     * Does one time step on a round planet, letting daisies grow and die according to their local temperature
+     * @returns whether any color enabled in an update kernel configuration grows at a latitude
      */
-    void UpdateDaisyAmountsOnRoundPlanet() {
-        float growthAmounts[COLORS][numberOfLatitudes];
-        CalculateGrowthAmountsOnRoundPlanet(growthAmounts);
-        DoDaisyGrowthOnRoundPlanet(growthAmounts);
-        ClearCachedValues();
+    template <int configuration>
+    bool LatitudeHasLife(int latitude) const {
+        for (int i=0; i<COLORS; i++) {
+            if (KernelHasColor(configuration, i) && groundAtLatitudes[latitude].proportion[i] > 0.0f) return true;
+        }
+        return false;
     }
 
     /**
-     * stores the amount that each type of daisy grows at this latitude into a growth array
+     * Fills in the latitude context for this update: the bare ground at each latitude, and the global albedo and
+     * temperature, found in the same pass over the latitudes. With latitudinal conduction, also the temperature of each
+     * latitude, with the fourth roots taken together in a second pass.
      */
-    void CalculateGrowthAmountsOnRoundPlanet(float (&growthAmounts)[COLORS][numberOfLatitudes]) {
+    template <int configuration>
+    void PrepareLatitudeContext() {
+        constexpr bool conducting = (configuration & CONDUCTION_KERNEL) != 0;
         for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
+            const GroundCover& cover = groundAtLatitudes[latitude];
+            // every color counts, since a disabled color can still cover ground it was given at the start
+            Scalar bareGround = 1.0f;
+            for (int i=0; i<COLORS; i++) {
+                bareGround -= cover.proportion[i];
+            }
+            latitudeContext.bareGround[latitude] = bareGround;
+            // the same sum as GetAverageAlbedoOnRoundPlanet
+            Scalar albedoAtLatitude = bareGround * groundAlbedo;
             for (int i=0; i<COLORS; i++) {
-                if (enabledColors[i]) growthAmounts[i][latitude] = GrowthRateAtLatitude(i, latitude) * timePerUpdate;
+                albedoAtLatitude += cover.proportion[i] * flowerAlbedos[i];
             }
+            latitudeContext.absorbed[latitude] = latitudeContext.insolation[latitude] * (1 - albedoAtLatitude);
         }
+        latitudeContext.globalAlbedo = 1 - Sum(latitudeContext.absorbed, numberOfLatitudes, summation) / numberOfLatitudes;
+        latitudeContext.globalTemperature = GlobalTemperatureFor(latitudeContext.globalAlbedo, solarLuminosity);
+        int first = 0;
+        while (first < numberOfLatitudes && !LatitudeHasLife<configuration>(first)) first++;
+        int end = numberOfLatitudes;
+        while (end > first && !LatitudeHasLife<configuration>(end - 1)) end--;
+        if (first < end && seeder.GetPolicy().dispersalRate > 0.0f) {
+            // daisies dispersing from a living latitude reach the latitudes on either side of it
+            first = std::max(first - 1, 0);
+            end = std::min(end + 1, numberOfLatitudes);
+        }
+        latitudeContext.firstActiveLatitude = first;
+        latitudeContext.endActiveLatitude = end;
+        if (conducting) {
+            Scalar globalShare = (1 - latitudinalConduction) * latitudeContext.globalTemperature;
+            for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
+                // the sunlight absorbed at this latitude, as in TemperatureOfInternalLatitude
+                Scalar latitudeTemperature = FourthRoot((fluxConstant * solarLuminosity * latitudeContext.absorbed[latitude]) / stefansConstant) - celsiusToKelvin;
+                latitudeContext.conductingTemperature[latitude] = latitudinalConduction * latitudeTemperature + globalShare;
+            }
+        }
+    }
+
+    /**
+     * stores the amount that each type of daisy grows at this latitude into a growth array, including daisies
+     * dispersing from neighboring latitudes if the seeding policy allows it. The latitude context must be prepared first,
+     * and only its run of active latitudes is stored.
+     */
+    template <int configuration>
+    void CalculateGrowthAmountsOnRoundPlanet(Scalar (&growthAmounts)[COLORS][numberOfLatitudes]) {
+        float dispersalRate = seeder.GetPolicy().dispersalRate;
+        for (int latitude = latitudeContext.firstActiveLatitude; latitude < latitudeContext.endActiveLatitude; latitude++) {
+            for (int i=0; i<COLORS; i++) {
+                if (!KernelHasColor(configuration, i)) continue;
+                growthAmounts[i][latitude] = GrowthRateAtLatitude<(configuration & CONDUCTION_KERNEL) != 0>(i, latitude, latitudeContext) * timePerUpdate;
+                if (dispersalRate > 0.0f) growthAmounts[i][latitude] += DispersalRateAtLatitude(i, latitude, dispersalRate) * timePerUpdate;
+            }
+        }
+    }
+
+    /**
+     * Calculates the net rate that daisies of a color spread into a latitude from its neighbors. The poles and the equator
+     * reflect, so dispersal moves daisies around without changing how many there are.
+     * @param color The color of these daisies
+     * @param latitude The latitude on the planet, ranging from 0 (polar) to 89 (equitorial)
+     * @param dispersalRate The proportion of the difference from the neighbors' average that moves per time unit
+     */
+    Scalar DispersalRateAtLatitude(int color, int latitude, float dispersalRate) {
+        Scalar poleward = groundAtLatitudes[latitude > 0 ? latitude - 1 : latitude].proportion[color];
+        Scalar equatorward = groundAtLatitudes[latitude < numberOfLatitudes - 1 ? latitude + 1 : latitude].proportion[color];
+        return dispersalRate * (0.5f * (poleward + equatorward) - groundAtLatitudes[latitude].proportion[color]);
     }
 
     /**
      * Given an array of how much each type of daisy should grow or die this update at this latitude, increments
      * or decrements the daisy amounts
-     */
-    void DoDaisyGrowthOnRoundPlanet(float (&growthAmounts)[COLORS][numberOfLatitudes]) {
+     * @param trackingHabitats Whether to recount the habitats of every color from the new cover
+     */
+    template <int configuration>
+    void DoDaisyGrowthOnRoundPlanet(Scalar (&growthAmounts)[COLORS][numberOfLatitudes], bool trackingHabitats) {
+        // seeding is applied to each latitude as it is updated, rather than in another pass
+        bool seeding = seeder.BeginStep();
+        bool trackingExtinctions = seeder.TracksExtinctions();
+        float seedAmount = seeder.GetPolicy().roundSeedAmount;
+        Scalar totals[COLORS] = {};
+        if (trackingHabitats) {
+            for (int i=0; i<COLORS; i++) habitats[i].Clear();
+        }
         for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
+            bool active = latitude >= latitudeContext.firstActiveLatitude && latitude < latitudeContext.endActiveLatitude;
             for (int i=0; i<COLORS; i++) {
-                if (enabledColors[i]) groundAtLatitudes[latitude].IncrementColor(i, growthAmounts[i][latitude]);
+                if (KernelHasColor(configuration, i) && active) groundAtLatitudes[latitude].IncrementColor(i, growthAmounts[i][latitude], extinctionThreshold);
+            }
+            if (seeding) seeder.SeedCover(groundAtLatitudes[latitude].proportion, enabledColors, seedAmount);
+            if (trackingExtinctions) {
+                for (int i=0; i<COLORS; i++) totals[i] += groundAtLatitudes[latitude].proportion[i];
+            }
+            if (trackingHabitats) {
+                for (int i=0; i<COLORS; i++) habitats[i].Add(latitude, ScalarValue(groundAtLatitudes[latitude].proportion[i]));
             }
         }
+        if (trackingExtinctions) seeder.EndStep(totals);
     }
 
     /**
@@ -378,17 +784,12 @@ class World : emp::World<float> {
      * @param color The color of daisy
      */
     float AverageLatitude(int color) {
-        float totalLatitudeProportion = 0.0;
-        float totalProportion = 0.0;
-        for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
-            totalProportion += groundAtLatitudes[latitude].proportion[color];
-            totalLatitudeProportion += latitude * groundAtLatitudes[latitude].proportion[color];
-        }
-        if (totalProportion < 0.0001) {
+        const Habitat& habitat = GetHabitat(color);
+        if (habitat.proportion < 0.0001) {
             // there aren't enough daisies of this color to get a meaningful average
             return std::numeric_limits<float>::quiet_NaN();
         }
-        return totalLatitudeProportion / totalProportion;
+        return habitat.latitudeProportion / habitat.proportion;
     }
 
     /**
@@ -397,12 +798,7 @@ class World : emp::World<float> {
      * @returns The maximal latitude (most equatorial) of that habitat, or -1 if no daisies of this color exist
      */
     int MaxLatitude(int color) {
-        for (int latitude = numberOfLatitudes - 1; latitude >= 0; latitude--) {
-            if (groundAtLatitudes[latitude].proportion[color] > 0.0) {
-                return latitude;
-            }
-        }
-        return -1;
+        return GetHabitat(color).Last();
     }
 
     /**
@@ -411,12 +807,7 @@ class World : emp::World<float> {
      * @returns The minimum latitude (most polar) of that habitat, or numberOfLatitudes if no daisies of this color exist
      */
     int MinLatitude(int color) {
-        for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
-            if (groundAtLatitudes[latitude].proportion[color] > 0.0) {
-                return latitude;
-            }
-        }
-        return numberOfLatitudes;
+        return GetHabitat(color).First();
     }
 
     /**
@@ -424,7 +815,7 @@ class World : emp::World<float> {
      * may get started again.
      * @param The minimum amounts of each type of daisy
      */
-    void BoostDaisiesIfExtinctOnRoundWorld(float whiteBoost = 0.001, float blackBoost = 0.001, float grayBoost = 0.001) {
+    void BoostDaisiesIfExtinctOnRoundWorld(float whiteBoost, float blackBoost, float grayBoost) {
         for (int latitude = 0; latitude < numberOfLatitudes; latitude++) {
             if (enabledColors[WHITE] && groundAtLatitudes[latitude].proportion[WHITE] < whiteBoost) groundAtLatitudes[latitude].proportion[WHITE] = whiteBoost;
             if (enabledColors[BLACK] && groundAtLatitudes[latitude].proportion[BLACK] < blackBoost) groundAtLatitudes[latitude].proportion[BLACK] = blackBoost;
@@ -436,10 +827,10 @@ class World : emp::World<float> {
      * Adds proportions for each type of daisy to a data file
      */
     void AddDaisyProportionsToDataFile(emp::DataFile& file) {
-        file.AddFun<float>([this]() { return Proportion(WHITE, -1); }, "a_w", "Proportion of white daisies");
-        file.AddFun<float>([this]() { return Proportion(BLACK, -1); }, "a_b", "Proportion of black daisies");
+        file.AddFun<float>([this]() { return ScalarValue(Proportion(WHITE, -1)); }, "a_w", "Proportion of white daisies");
+        file.AddFun<float>([this]() { return ScalarValue(Proportion(BLACK, -1)); }, "a_b", "Proportion of black daisies");
         if (enabledColors[GRAY]) {
-            file.AddFun<float>([this]() { return Proportion(GRAY, -1); }, "a_g", "Proportion of gray daisies");
+            file.AddFun<float>([this]() { return ScalarValue(Proportion(GRAY, -1)); }, "a_g", "Proportion of gray daisies");
         }
     }
 
@@ -484,9 +875,9 @@ class World : emp::World<float> {
     /**
      * @returns the averaged total albedo over the entire planet (how much sunlight is reflected in aggregate). If the world is round
      */
-    float GetTotalAlbedo() {
-        if (std::isnan(cachedGlobalAlbedo)) {
-            cachedGlobalAlbedo = roundWorld ? GetAverageAlbedoOnRoundPlanet() : ground.GetTotalAlbedo();
+    Scalar GetTotalAlbedo() {
+        if (std::isnan(ScalarValue(cachedGlobalAlbedo))) {
+            cachedGlobalAlbedo = roundWorld ? GetAverageAlbedoOnRoundPlanet() : ground.GetTotalAlbedo(flowerAlbedos, groundAlbedo);
         }
         return cachedGlobalAlbedo;
     }
@@ -494,38 +885,51 @@ class World : emp::World<float> {
     /**
      * @returns the average global temperature of the planet in Celsius, based on average albedo and solar luminosity
      */
-    float GetGlobalTemperature() {
-        if (std::isnan(cachedGlobalTemperature)) {
-            float globalAlbedo = GetTotalAlbedo();
-            float globalAbsorbsion = 1 - globalAlbedo;
-            // calculate the global temperature using the Stefan-Boltzman equation
-            // equation (4) of Daisyworld
-            cachedGlobalTemperature = std::pow((fluxConstant * solarLuminosity * globalAbsorbsion) / stefansConstant, 0.25) - celsiusToKelvin;
+    Scalar GetGlobalTemperature() {
+        if (std::isnan(ScalarValue(cachedGlobalTemperature))) {
+            cachedGlobalTemperature = GlobalTemperatureFor(GetTotalAlbedo(), solarLuminosity);
         }
         return cachedGlobalTemperature;
     }
 
+    /**
+     * Calculates what the global temperature would be for some albedo and luminosity, without changing the world
+     * @param globalAlbedo The average albedo of the planet
+     * @param luminosity The dimensionless solar luminosity
+     * @returns the temperature in Celsius
+     * @tparam T The number type to compute in, Scalar unless given
+     */
+    template <typename T = Scalar>
+    T GlobalTemperatureFor(T globalAlbedo, T luminosity) {
+        using std::pow;
+        T globalAbsorbsion = 1 - globalAlbedo;
+        // calculate the global temperature using the Stefan-Boltzman equation
+        // equation (4) of Daisyworld
+        return pow((fluxConstant * luminosity * globalAbsorbsion) / stefansConstant, 0.25) - celsiusToKelvin;
+    }
+
     /**
      * Gets the average temperature at a display latitude band on the round planet
      * @param displayLatitude The displayed latitude on the planet, ranging from 0 (equatorial) to 9 (polar)
      */
-    float TemperatureOfLatitude(int displayLatitude) {
+    Scalar TemperatureOfLatitude(int displayLatitude) {
         // based on equation (4) of Daisyworld
-        float latitudinalAlbedo = 0.0;
+        using std::pow;
+        Scalar latitudinalAlbedo = 0.0f;
         for (int i=-1; i<COLORS; i++) {
             latitudinalAlbedo += (i < 0 ? groundAlbedo : flowerAlbedos[i]) * Proportion(i, displayLatitude);
         }
-        float latitudalAbsorbtivity = 1 - latitudalAbsorbtivity;
+        Scalar latitudalAbsorbtivity = 1 - latitudinalAlbedo;
         int latitudesPerBand = numberOfLatitudes / numberOfDisplayedLatitudes;
         int internalLatitude = numberOfLatitudes - latitudesPerBand * displayLatitude - latitudesPerBand / 2;
-        float scaledLatitudalAbsorbtivity = latitudalAbsorbtivity * GetLuminosityMultiplierAtLatitude(internalLatitude);
-        return std::pow((fluxConstant * solarLuminosity * scaledLatitudalAbsorbtivity) / stefansConstant, 0.25) - celsiusToKelvin;
+        Scalar scaledLatitudalAbsorbtivity = latitudalAbsorbtivity * GetLuminosityMultiplierAtLatitude(internalLatitude);
+        return pow((fluxConstant * solarLuminosity * scaledLatitudalAbsorbtivity) / stefansConstant, 0.25) - celsiusToKelvin;
     }
 
     /**
      * Sets the dimensionless solar luminosity of the world
      */
-    void SetSolarLuminosity(float _solarLuminosity) {
+    void SetSolarLuminosity(Scalar _solarLuminosity) {
         solarLuminosity = _solarLuminosity;
         ClearCachedValues();
     }
@@ -533,9 +937,109 @@ class World : emp::World<float> {
     /**
      * @returns the dimensionless solar luminosity, with values typically around 1
      */
-    float GetSolarLuminosity() {
+    Scalar GetSolarLuminosity() {
         return solarLuminosity;
     }
+
+    /**
+     * Sets the death rate of daisies per unit time, gamma in the Daisyworld paper
+     */
+    void SetDeathRate(Scalar _deathRate) {
+        deathRate = _deathRate;
+    }
+
+    /**
+     * Sets how strongly local temperatures differ from the global temperature based on albedo, q' in the Daisyworld paper
+     */
+    void SetConductivityConstant(Scalar _conductivityConstant) {
+        conductivityConstant = _conductivityConstant;
+    }
+
+    /**
+     * Sets how much of the temperature conducting to each patch of flowers on a round world comes from its own latitude
+     * rather than from the global temperature. At 0, the default, local temperatures follow equation (7) of the
+     * Daisyworld paper with the global temperature. At 1, each latitude only exchanges heat with itself.
+     */
+    void SetLatitudinalConduction(float _latitudinalConduction) {
+        latitudinalConduction = _latitudinalConduction;
+    }
+
+    /**
+     * @returns the proportion of the temperature conducting to each patch of flowers that comes from its own latitude
+     */
+    float GetLatitudinalConduction() {
+        return latitudinalConduction;
+    }
+
+    /**
+     * Sets how the global albedo and cover of a round planet are added up over its latitudes: pairwise, which is fast,
+     * or with compensation for rounding errors, which is more exact
+     */
+    void SetSummation(Summation _summation) {
+        summation = _summation;
+        ClearCachedValues();
+    }
+
+    Summation GetSummation() {
+        return summation;
+    }
+
+    /**
+     * Sets the proportion a color of daisy dies out below, 0.001 by default. At 0, daisies never die out entirely but
+     * decay into subnormal floats, so runs should flush subnormals to zero, as with FlushSubnormalsToZero.
+     */
+    void SetExtinctionThreshold(float _extinctionThreshold) {
+        extinctionThreshold = _extinctionThreshold;
+    }
+
+    float GetExtinctionThreshold() {
+        return extinctionThreshold;
+    }
+
+    /**
+     * @returns how much a color grew, or shrank if negative, in the last update of a flat planet, before it was cleared
+     * for falling below the extinction threshold
+     */
+    Scalar GetLastGrowthAmount(int color) {
+        return lastGrowthAmounts[color];
+    }
+
+    /**
+     * Sets whether updates add up the energy budget of the planet, to be read with TakeEnergyBudget. Off by default, when
+     * updates skip it entirely. Data files recording the energy budget turn it on.
+     */
+    void SetEnergyBudgetTracking(bool tracking) {
+        trackingEnergyBudget = tracking;
+        energyBudgetTotals = EnergyBudget();
+    }
+
+    /**
+     * @returns the energy budget averaged over the updates since it was last taken, or the budget of the current state
+     * if there have been none, and starts adding up the next one
+     */
+    EnergyBudget TakeEnergyBudget() {
+        EnergyBudget budget = energyBudgetTotals;
+        if (budget.updates == 0) return CurrentEnergyBudget();
+        energyBudgetTotals = EnergyBudget();
+        double scale = 1.0 / budget.updates;
+        budget.absorbed *= scale;
+        budget.emitted *= scale;
+        for (int band = 0; band < numberOfDisplayedLatitudes; band++) {
+            budget.bandAbsorbed[band] *= scale;
+            budget.bandEmitted[band] *= scale;
+        }
+        return budget;
+    }
+
+    /**
+     * Sets the albedo of a color of daisy
+     * @param color The color of daisy
+     * @param albedo The proportion of sunlight those daisies reflect
+     */
+    void SetFlowerAlbedo(int color, Scalar albedo) {
+        flowerAlbedos[color] = albedo;
+        ClearCachedValues();
+    }
   
     /** 
      * Sets whether the world is round (has different latitudes) or not. When changing world types, moves the current daisy proportions over.
@@ -557,6 +1061,7 @@ class World : emp::World<float> {
                 }
             }
             roundWorld = _roundWorld;
+            ClearCachedValues();
         }
     }
 
@@ -571,7 +1076,7 @@ class World : emp::World<float> {
      * @returns the proportion of the world that is covered by white daisies, from 0 to 1. On a round world,
      * averages the white areas of each latitude.
      */
-    float GetProportionWhite() {
+    Scalar GetProportionWhite() {
         return Proportion(WHITE, -1);
     }
 
@@ -579,7 +1084,7 @@ class World : emp::World<float> {
      * @returns the proportion of the world that is covered by black daisies, from 0 to 1. On a round world,
      * averages the black areas of each latitude.
      */
-    float GetProportionBlack() {
+    Scalar GetProportionBlack() {
         return Proportion(BLACK, -1);
     }
 
@@ -587,7 +1092,7 @@ class World : emp::World<float> {
      * @returns the proportion of the world that is covered by gray daisies, from 0 to 1. On a round world,
      * averages the gray areas of each latitude.
      */
-    float GetProportionGray() {
+    Scalar GetProportionGray() {
         return Proportion(GRAY, -1);
     }
 
@@ -595,16 +1100,39 @@ class World : emp::World<float> {
      * @returns the proportion of the world that is not covered by daisies, from 0 to 1. On a round world,
      * averages the ground areas of each latitude.
      */
-    float GetProportionGround() {
+    Scalar GetProportionGround() {
         return Proportion(-1, -1);
     }
 
+    /**
+     * @returns the proportion of the world that is covered by daisies of a color, from 0 to 1. On a round world,
+     * averages the areas of each latitude.
+     */
+    Scalar GetProportion(int color) {
+        return Proportion(color, -1);
+    }
+
+    /**
+     * @returns the number of latitudes the round planet is subdivided into internally
+     */
+    int GetNumberOfLatitudes() {
+        return numberOfLatitudes;
+    }
+
+    /**
+     * On a round world, how much ground is covered by daisies of a color at one of the internal latitudes
+     * @param latitude The internal latitude, ranging from 0 (polar) to GetNumberOfLatitudes() - 1 (equatorial)
+     */
+    Scalar GetProportionAtInternalLatitude(int color, int latitude) {
+        return groundAtLatitudes[latitude].proportion[color];
+    }
+
     /**
      * On a round world, how much ground is covered by white daisies at this latitude.
      * @param displayLatitude The displayed latitude of the planet, which may differ from the internal subdivision.
      * By default, there are 10 latitude classes, from 0 (equatorial) to 9 (polar)
      */
-    float GetProportionWhiteAtLatitude(int displayLatitude) {
+    Scalar GetProportionWhiteAtLatitude(int displayLatitude) {
         return Proportion(WHITE, displayLatitude);
     }
 
@@ -613,7 +1141,7 @@ class World : emp::World<float> {
      * @param displayLatitude The displayed latitude of the planet, which may differ from the internal subdivision.
      * By default, there are 10 latitude classes, from 0 (equatorial) to 9 (polar)
      */
-    float GetProportionBlackAtLatitude(int displayLatitude) {
+    Scalar GetProportionBlackAtLatitude(int displayLatitude) {
         return Proportion(BLACK, displayLatitude);
     }
 
@@ -622,7 +1150,7 @@ class World : emp::World<float> {
      * @param displayLatitude The displayed latitude of the planet, which may differ from the internal subdivision.
      * By default, there are 10 latitude classes, from 0 (equatorial) to 9 (polar)
      */
-    float GetProportionGrayAtLatitude(int displayLatitude) {
+    Scalar GetProportionGrayAtLatitude(int displayLatitude) {
         return Proportion(GRAY, displayLatitude);
     }
 
@@ -631,7 +1159,7 @@ class World : emp::World<float> {
      * @param displayLatitude The displayed latitude of the planet, which may differ from the internal subdivision.
      * By default, there are 10 latitude classes, from 0 (equatorial) to 9 (polar)
      */
-    float GetProportionGroundAtLatitude(int displayLatitude) {
+    Scalar GetProportionGroundAtLatitude(int displayLatitude) {
         return Proportion(-1, displayLatitude);
     }
 
@@ -656,6 +1184,27 @@ class World : emp::World<float> {
         SetColorEnabled(GRAY, _grayEnabled);
     }
 
+    /**
+     * @returns whether a color of daisy is enabled
+     */
+    bool IsColorEnabled(int color) {
+        return enabledColors[color];
+    }
+
+    /**
+     * Sets how daisies that have died out are given a chance to grow again
+     */
+    void SetSeedingPolicy(const SeedingPolicy& policy) {
+        seeder = Seeder(policy);
+    }
+
+    /**
+     * @returns how daisies that have died out are given a chance to grow again
+     */
+    const SeedingPolicy& GetSeedingPolicy() {
+        return seeder.GetPolicy();
+    }
+
     /**
      * Enables or disables changes in the amounts of daisies
      */
@@ -668,16 +1217,102 @@ class World : emp::World<float> {
      * death are not disabled
      */
     void Update() {
-        emp::World<float>::Update();
-        if (daisiesCanGrowAndDie) {
-            if (roundWorld) {
-                UpdateDaisyAmountsOnRoundPlanet();
+        UpdateN(1);
+    }
+
+    /**
+     * Performs n time steps, with exactly the same results and data file output as calling Update n times. The update
+     * kernel specialized for the world's configuration is chosen once, so disabled colors and the unused flat or round
+     * path are compiled out of the loop. The global albedo and temperature are computed once per step without the
+     * cache, which is only cleared every step when a data file may read it.
+     */
+    void UpdateN(int n) {
+        if (!daisiesCanGrowAndDie) {
+            // the cover doesn't change, so every update has the energy budget of the current state
+            EnergyBudget budget = trackingEnergyBudget ? CurrentEnergyBudget() : EnergyBudget();
+            for (int step = 0; step < n; step++) {
+                emp::World<float>::Update();
+                if (trackingEnergyBudget) energyBudgetTotals.AddUpdate(budget);
+            }
+            return;
+        }
+        static constexpr auto kernels = MakeUpdateKernels(std::make_integer_sequence<int, KERNEL_CONFIGURATIONS>());
+        (this->*kernels[GetKernelConfiguration()])(n);
+    }
+
+    /**
+     * Update kernels are specialized on a configuration with bit (1 << color) set for each enabled color, ROUND_KERNEL
+     * set if the world is round, and CONDUCTION_KERNEL set if it is round with latitudinal conduction
+     */
+    static constexpr int ROUND_KERNEL = 1 << COLORS;
+    static constexpr int CONDUCTION_KERNEL = 2 << COLORS;
+    static constexpr int KERNEL_CONFIGURATIONS = 4 << COLORS;
+
+    /**
+     * @returns the configuration of the update kernel for this world
+     */
+    int GetKernelConfiguration() {
+        int configuration = roundWorld ? ROUND_KERNEL : 0;
+        if (roundWorld && latitudinalConduction != 0.0f) configuration |= CONDUCTION_KERNEL;
+        for (int i=0; i<COLORS; i++) {
+            if (enabledColors[i]) configuration |= 1 << i;
+        }
+        return configuration;
+    }
+
+    private:
+
+    /**
+     * Performs n time steps of a world with this configuration
+     */
+    template <int configuration>
+    void RunUpdateKernel(int n) {
+        bool writingFiles = !files.empty();
+        // the data files read the habitats of a round world every update, so they are counted during its growth pass
+        bool trackingHabitats = writingFiles && (configuration & ROUND_KERNEL) != 0;
+        // the energy budget reuses the sunlight and temperatures each update computes anyway, and is only checked once
+        // per update
+        bool trackingEnergy = trackingEnergyBudget;
+        for (int step = 0; step < n; step++) {
+            emp::World<float>::Update();
+            if constexpr ((configuration & ROUND_KERNEL) != 0) {
+                Scalar growthAmounts[COLORS][numberOfLatitudes];
+                PrepareLatitudeContext<configuration>();
+                if (trackingEnergy) {
+                    EnergyBudget budget;
+                    bool conducting = (configuration & CONDUCTION_KERNEL) != 0;
+                    AddToEnergyBudgetOnRoundPlanet(budget, latitudeContext.absorbed, conducting ? latitudeContext.conductingTemperature : nullptr, latitudeContext.globalTemperature);
+                    energyBudgetTotals.AddUpdate(budget);
+                }
+                CalculateGrowthAmountsOnRoundPlanet<configuration>(growthAmounts);
+                DoDaisyGrowthOnRoundPlanet<configuration>(growthAmounts, trackingHabitats);
             } else {
-                UpdateDaisyAmountsOnFlatPlanet();
+                Scalar globalAlbedo = ground.GetTotalAlbedo(flowerAlbedos, groundAlbedo);
+                Scalar globalTemperature = GlobalTemperatureFor(globalAlbedo, solarLuminosity);
+                if (trackingEnergy) {
+                    EnergyBudget budget;
+                    AddToEnergyBudget(budget, globalAlbedo, globalTemperature);
+                    energyBudgetTotals.AddUpdate(budget);
+                }
+                GrowDaisiesOnFlatPlanet<configuration>(globalAlbedo, globalTemperature);
             }
+            if (writingFiles) ClearCachedValues();
+            habitatsCurrent = trackingHabitats;
         }
+        ClearCachedValues();
+        habitatsCurrent = trackingHabitats && n > 0;
     }
 
+    /**
+     * @returns the update kernel for each configuration, indexed by configuration
+     */
+    template <int... configurations>
+    static constexpr std::array<void (DaisyWorld::*)(int), sizeof...(configurations)> MakeUpdateKernels(std::integer_sequence<int, configurations...>) {
+        return {&DaisyWorld::RunUpdateKernel<configurations>...};
+    }
+
+    public:
+
     /**
      * @returns The average latitude of the habitat of white daisies
      */
@@ -747,22 +1382,164 @@ class World : emp::World<float> {
         return MinLatitude(GRAY);
     }
 
+    /**
+     * Calculates the Jacobian of the growth rates of each enabled color at each latitude with respect to their proportions,
+     * at the current state. At a steady state, its eigenvalues tell how quickly the world recovers from small disturbances.
+     */
+    GrowthJacobian GetGrowthJacobian() {
+        GrowthJacobian jacobian;
+        std::vector<int> colors;
+        for (int i=0; i<COLORS; i++) {
+            if (enabledColors[i]) colors.push_back(i);
+        }
+        int k = colors.size();
+        int latitudes = roundWorld ? numberOfLatitudes : 1;
+        jacobian.colorsPerBlock = k;
+        jacobian.numberOfBlocks = latitudes;
+        jacobian.blocks.resize(latitudes * k * k);
+        jacobian.albedoSensitivity.resize(latitudes * k);
+        jacobian.albedoGradient.resize(latitudes * k);
+
+        double globalAlbedo = ScalarValue(GetTotalAlbedo());
+        double globalTemperature = ScalarValue(GetGlobalTemperature());
+        double q = ScalarValue(conductivityConstant);
+        double gamma = ScalarValue(deathRate);
+        // how the global temperature changes with the global albedo, from equation (4)
+        double globalTemperatureSlope = -(globalTemperature + celsiusToKelvin) / (4.0 * (1.0 - globalAlbedo));
+        // with latitudinal conduction, part of the conducting temperature is the temperature of the latitude instead
+        double conduction = roundWorld ? latitudinalConduction : 0.0;
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            GroundCover& cover = roundWorld ? groundAtLatitudes[latitude] : ground;
+            double bareGround = ScalarValue(cover.GetProportionGround());
+            // how the temperature of this latitude changes with its own albedo
+            double latitudeTemperatureSlope = 0.0;
+            if (conduction != 0.0) {
+                double latitudeAlbedo = ScalarValue(cover.GetTotalAlbedo(flowerAlbedos, groundAlbedo));
+                latitudeTemperatureSlope = -(ScalarValue(TemperatureOfInternalLatitude(latitude)) + celsiusToKelvin) / (4.0 * (1.0 - latitudeAlbedo));
+            }
+            for (int a = 0; a < k; a++) {
+                int color = colors[a];
+                double proportion = ScalarValue(cover.proportion[color]);
+                double localTemperature = ScalarValue(roundWorld ? LocalTemperatureAtLatitude(color, latitude) : LocalTemperature(color));
+                double growthFunction = ScalarValue(GrowthRateFunction(localTemperature));
+                double growthFunctionSlope = 2 * 0.003265 * (22.5 - localTemperature);
+                int row = latitude * k + a;
+                // equation (1) differentiated with respect to the proportions at the same latitude, holding the global albedo fixed
+                for (int b = 0; b < k; b++) {
+                    double latitudeAlbedoDifference = ScalarValue(flowerAlbedos[colors[b]] - groundAlbedo);
+                    jacobian.blocks[row * k + b] = (a == b ? growthFunction * bareGround - gamma : 0.0) - proportion * growthFunction
+                        + proportion * bareGround * growthFunctionSlope * conduction * latitudeTemperatureSlope * latitudeAlbedoDifference;
+                }
+                // local temperature depends on the global albedo directly, and through the share of the global temperature
+                jacobian.albedoSensitivity[row] = proportion * bareGround * growthFunctionSlope * (q + (1.0 - conduction) * globalTemperatureSlope);
+                // how much this proportion changes the global albedo, weighted by sunlight on a round world
+                double albedoDifference = ScalarValue(flowerAlbedos[color] - groundAlbedo);
+                jacobian.albedoGradient[row] = roundWorld ? GetLuminosityMultiplierAtLatitude(latitude) * albedoDifference / numberOfLatitudes : albedoDifference;
+            }
+        }
+        return jacobian;
+    }
+
+    /**
+     * @returns the leading eigenvalue of the growth Jacobian at the current state, which should be a steady state
+     */
+    StabilityResult AnalyzeStability() {
+        GrowthJacobian jacobian = GetGrowthJacobian();
+        return StabilityAnalyzer(jacobian).Analyze();
+    }
+
+    /**
+     * A steady state of a flat world where only one color of daisy grows
+     */
+    struct SteadyState {
+        Scalar proportion;
+        Scalar temperature;
+        // the rate per time unit that small disturbances grow, which is negative if the state is stable
+        double eigenvalue;
+
+        bool IsStable() const {
+            return eigenvalue < 0.0;
+        }
+    };
+
+    /**
+     * Finds every steady state of a flat world where only one color of daisy grows, at the current luminosity, by solving
+     * equation (1) for the cover where growth balances death instead of running the world. The roots are bracketed on a
+     * grid of covers, narrowed by bisection, and finished with a Newton step so that Dual numbers carry their derivatives.
+     * @param color The color of daisy, assuming the other colors have no cover
+     * @param samples How many intervals the covers from 0 to 1 are divided into to bracket the roots
+     * @returns the steady states from the least cover to the most, starting with the barren planet
+     */
+    std::vector<SteadyState> FindSingleSpeciesSteadyStates(int color, int samples = 1000) {
+        std::vector<SteadyState> states;
+        Scalar slope;
+        // the barren planet is always a steady state, and daisies seeded on it grow at the rate per cover of no cover
+        Scalar previousGrowth = SingleSpeciesGrowthRatePerCover(color, 0.0f, slope);
+        states.push_back({0.0f, GlobalTemperatureFor(groundAlbedo, solarLuminosity), ScalarValue(previousGrowth)});
+        for (int i = 1; i <= samples; i++) {
+            float high = (float)i / samples;
+            Scalar growth = SingleSpeciesGrowthRatePerCover(color, high, slope);
+            bool crossed = (ScalarValue(previousGrowth) > 0.0f) != (ScalarValue(growth) > 0.0f);
+            previousGrowth = growth;
+            if (!crossed) continue;
+            float low = (float)(i - 1) / samples;
+            bool growingBelow = ScalarValue(SingleSpeciesGrowthRatePerCover(color, low, slope)) > 0.0f;
+            for (int iteration = 0; iteration < 30; iteration++) {
+                float middle = 0.5f * (low + high);
+                bool growingInMiddle = ScalarValue(SingleSpeciesGrowthRatePerCover(color, middle, slope)) > 0.0f;
+                (growingInMiddle == growingBelow ? low : high) = middle;
+            }
+            Scalar proportion = 0.5f * (low + high);
+            Scalar root = SingleSpeciesGrowthRatePerCover(color, proportion, slope);
+            proportion = proportion - root / slope;
+            SingleSpeciesGrowthRatePerCover(color, proportion, slope);
+            Scalar globalAlbedo = groundAlbedo + proportion * (flowerAlbedos[color] - groundAlbedo);
+            // the derivative of equation (1) with respect to the cover, where the growth rate per cover is 0
+            states.push_back({proportion, GlobalTemperatureFor(globalAlbedo, solarLuminosity), ScalarValue(proportion * slope)});
+        }
+        return states;
+    }
+
     /**
      * Sets up a data file tracking the time, solar luminosity, amounts of daisies, and global temperature of Daisyworld
+     * @param includeStability Whether to also record the leading eigenvalue of the growth Jacobian and the recovery time,
+     * which is only meaningful when records are taken at steady states
+     * @param includeEnergyBudget Whether to also record the energy budget averaged over the updates since the previous
+     * record, globally and on a round world for each displayed latitude band
      * @returns the data file
      */
-    emp::DataFile& SetupDataFile(const std::string& fileName) {
+    emp::DataFile& SetupDataFile(const std::string& fileName, bool includeStability = false, bool includeEnergyBudget = false) {
         emp::DataFile& file = SetupFile(fileName);
         // add variables to the data file
         file.AddVar(update, "t", "update");
-        file.AddVar(solarLuminosity, "L", "Solar luminosity");
+        file.AddFun<float>([this]() { return ScalarValue(solarLuminosity); }, "L", "Solar luminosity");
         AddDaisyProportionsToDataFile(file);
         // on a round world, add the average latitudes of each type of daisy
         if (roundWorld) {
             AddLatitudeStatisticsToDataFile(file);
         }
         // calculate the temperature each time the data file is written
-        file.AddFun<float>([this]() { return GetGlobalTemperature(); }, "temp", "Global temperature");
+        file.AddFun<float>([this]() { return ScalarValue(GetGlobalTemperature()); }, "temp", "Global temperature");
+        if (includeStability) {
+            // the stability is calculated once per record, and shared by both columns
+            file.AddFun<double>([this]() { lastStability = AnalyzeStability(); return lastStability.leadingEigenvalueReal; }, "lambda", "Leading eigenvalue of the growth Jacobian");
+            file.AddFun<double>([this]() { return lastStability.RecoveryTime(); }, "recovery_time", "Time units for a small disturbance to shrink by a factor of e");
+        }
+        if (includeEnergyBudget) {
+            SetEnergyBudgetTracking(true);
+            // the budget is taken once per record, and shared by every column
+            file.AddFun<double>([this]() { lastEnergyBudget = TakeEnergyBudget(); return lastEnergyBudget.absorbed; }, "absorbed", "Solar energy absorbed in W/m^2");
+            file.AddFun<double>([this]() { return lastEnergyBudget.emitted; }, "emitted", "Longwave energy emitted in W/m^2");
+            file.AddFun<double>([this]() { return lastEnergyBudget.Imbalance(); }, "imbalance", "Net energy absorbed in W/m^2");
+            if (roundWorld) {
+                for (int band = 0; band < numberOfDisplayedLatitudes; band++) {
+                    std::string suffix = "_" + std::to_string(band);
+                    file.AddFun<double>([this, band]() { return lastEnergyBudget.bandAbsorbed[band]; }, "absorbed" + suffix, "Solar energy absorbed by a latitude band in W/m^2");
+                    file.AddFun<double>([this, band]() { return lastEnergyBudget.bandEmitted[band]; }, "emitted" + suffix, "Longwave energy emitted by a latitude band in W/m^2");
+                    file.AddFun<double>([this, band]() { return lastEnergyBudget.BandImbalance(band); }, "imbalance" + suffix, "Net energy absorbed by a latitude band in W/m^2");
+                }
+            }
+        }
         // finish setting up the file
         file.PrintHeaderKeys();
         return file;
@@ -776,19 +1553,181 @@ class World : emp::World<float> {
     }
 
     /**
-     * If the black/white daisies have gone extinct, set their proportion to some small value so they may get started again
-     * @param The minimum amounts of each type of daisy
+     * @returns how many time units the world has been updated for
      */
-    void BoostDaisiesIfExtinct(float whiteBoost = 0.01, float blackBoost = 0.01, float grayBoost = 0.01) {
+    float GetTime() {
+        return update * timePerUpdate;
+    }
+
+    /**
+     * Everything about the world that changes as it updates, so a run can be rolled back, or continued from a saved point
+     */
+    struct State {
+        GroundCover ground;
+        GroundCover groundAtLatitudes[numberOfLatitudes];
+        Scalar solarLuminosity;
+        size_t update;
+        Seeder seeder;
+        // so updates undone by restoring the state drop out of the energy budget too
+        EnergyBudget energyBudgetTotals;
+    };
+
+    /**
+     * @returns the current state of the world
+     */
+    State SaveState() {
+        State state;
+        state.ground = ground;
+        std::copy(groundAtLatitudes, groundAtLatitudes + numberOfLatitudes, state.groundAtLatitudes);
+        state.solarLuminosity = solarLuminosity;
+        state.update = update;
+        state.seeder = seeder;
+        state.energyBudgetTotals = energyBudgetTotals;
+        return state;
+    }
+
+    /**
+     * Returns the world to a state saved from it, or from another world with the same settings
+     */
+    void RestoreState(const State& state) {
+        ground = state.ground;
+        std::copy(state.groundAtLatitudes, state.groundAtLatitudes + numberOfLatitudes, groundAtLatitudes);
+        solarLuminosity = state.solarLuminosity;
+        update = state.update;
+        seeder = state.seeder;
+        energyBudgetTotals = state.energyBudgetTotals;
+        ClearCachedValues();
+    }
+
+    /**
+     * @returns the proportion of each enabled color at each latitude, or over the whole planet on a flat world, ordered
+     * by latitude and then color like the rows of GetGrowthJacobian
+     */
+    std::vector<double> GetCoverVector() {
+        std::vector<double> cover;
+        int latitudes = roundWorld ? numberOfLatitudes : 1;
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            GroundCover& groundCover = roundWorld ? groundAtLatitudes[latitude] : ground;
+            for (int i=0; i<COLORS; i++) {
+                if (enabledColors[i]) cover.push_back(ScalarValue(groundCover.proportion[i]));
+            }
+        }
+        return cover;
+    }
+
+    /**
+     * Sets the proportion of each enabled color at each latitude, from a vector ordered like GetCoverVector
+     */
+    void SetCoverVector(const std::vector<double>& cover) {
+        int latitudes = roundWorld ? numberOfLatitudes : 1;
+        size_t index = 0;
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            GroundCover& groundCover = roundWorld ? groundAtLatitudes[latitude] : ground;
+            for (int i=0; i<COLORS; i++) {
+                if (enabledColors[i]) groundCover.proportion[i] = cover[index++];
+            }
+        }
+        ClearCachedValues();
+    }
+
+    /**
+     * Runs the cover of a round planet with any number of latitudes forward, with the parameters, luminosity, and
+     * enabled colors of this world, which itself is unchanged. The latitudes span the same range of sunlight from the
+     * pole to the equator as the latitudes of this world, so a profile with more latitudes samples the same planet more
+     * finely. Daisies are neither seeded nor dispersed.
+     * @param cover The proportion of each enabled color at each latitude, ordered by latitude and then color like
+     * GetCoverVector. Receives the cover after the updates.
+     * @param latitudes How many latitudes the profile has
+     * @param updates How many updates to run
+     * @param firstUpdate How many updates the profile has already been run for, so that stochastic rounding draws new
+     * noise on each update when a profile is run over several calls
+     * @tparam Stored How the cover is stored between updates. double, or float or FixedProportion16 to move less
+     * memory on profiles too large for the cache. Each update is still computed in doubles, and only rounded to the
+     * stored type as the new cover is written.
+     */
+    template <typename Stored>
+    void UpdateLatitudeProfile(std::vector<Stored>& cover, int latitudes, int updates, int firstUpdate = 0) {
+        std::vector<int> colors;
+        for (int i=0; i<COLORS; i++) {
+            if (enabledColors[i]) colors.push_back(i);
+        }
+        int k = colors.size();
+        if (k == 0 || latitudes < 2) return;
+        double luminosity = ScalarValue(solarLuminosity);
+        double q = ScalarValue(conductivityConstant);
+        double gamma = ScalarValue(deathRate);
+        double bareAlbedo = ScalarValue(groundAlbedo);
+        // the loops below run over all COLORS so they unroll, with no cover of the colors past the k enabled ones
+        double albedos[COLORS] = {};
+        for (int a = 0; a < k; a++) albedos[a] = ScalarValue(flowerAlbedos[colors[a]]);
+        double multiplierStep = (maxLuminosityMultiplier - minLuminosityMultiplier) / (latitudes - 1.0);
+        // the sunlight absorbed by each latitude, added up for the global albedo and kept for the conduction
+        std::vector<double> absorbed(latitudes);
+        for (int update = 0; update < updates; update++) {
+            // the global albedo weights each latitude by its sunlight, as in GetAverageAlbedoOnRoundPlanet
+            for (int latitude = 0; latitude < latitudes; latitude++) {
+                const Stored* stored = &cover[(size_t)latitude * k];
+                double proportion[COLORS];
+                for (int a = 0; a < COLORS; a++) proportion[a] = a < k ? (double)stored[a] : 0.0;
+                double bareGround = 1.0;
+                for (int a = 0; a < COLORS; a++) bareGround -= proportion[a];
+                double albedo = bareGround * bareAlbedo;
+                for (int a = 0; a < COLORS; a++) albedo += proportion[a] * albedos[a];
+                double multiplier = minLuminosityMultiplier + multiplierStep * latitude;
+                absorbed[latitude] = multiplier * (1 - albedo);
+            }
+            double globalAbsorbtivity = Sum(absorbed.data(), latitudes, summation) / latitudes;
+            double globalTemperature = GlobalTemperatureFor<double>(1 - globalAbsorbtivity, luminosity);
+            for (int latitude = 0; latitude < latitudes; latitude++) {
+                Stored* stored = &cover[(size_t)latitude * k];
+                double proportion[COLORS];
+                for (int a = 0; a < COLORS; a++) proportion[a] = a < k ? (double)stored[a] : 0.0;
+                double multiplier = minLuminosityMultiplier + multiplierStep * latitude;
+                double conductingTemperature = globalTemperature;
+                if (latitudinalConduction != 0.0f) {
+                    double latitudeTemperature = std::sqrt(std::sqrt(fluxConstant * luminosity * absorbed[latitude] / stefansConstant)) - celsiusToKelvin;
+                    conductingTemperature = latitudinalConduction * latitudeTemperature + (1 - latitudinalConduction) * globalTemperature;
+                }
+                double bareGround = 1.0;
+                for (int a = 0; a < COLORS; a++) bareGround -= proportion[a];
+                double growth[COLORS];
+                for (int a = 0; a < COLORS; a++) {
+                    // equations (1), (3), and (7) of Daisyworld, as in LocalTemperatureAtLatitude
+                    double localTemperature = q * ((1 - albedos[a]) * multiplier - globalAbsorbtivity) + conductingTemperature;
+                    double growthFunction = GrowthRateFunction(localTemperature);
+                    growth[a] = proportion[a] * (growthFunction * bareGround - gamma) * timePerUpdate;
+                }
+                for (int a = 0; a < k; a++) {
+                    proportion[a] += growth[a];
+                    // the same clamp as GroundCover::IncrementColor
+                    if (proportion[a] < extinctionThreshold) proportion[a] = 0.0;
+                    stored[a] = StoreProportion<Stored>(proportion[a], RoundingNoise((size_t)latitude * k + a, firstUpdate + update));
+                }
+            }
+        }
+    }
+
+    /**
+     * If the black/white daisies have gone extinct, set their proportion to some small value so they may get started again.
+     * The small value is the seed amount of the seeding policy.
+     */
+    void BoostDaisiesIfExtinct() {
         ClearCachedValues();
         if (roundWorld) {
-            BoostDaisiesIfExtinctOnRoundWorld();
+            float seedAmount = seeder.GetPolicy().roundSeedAmount;
+            BoostDaisiesIfExtinctOnRoundWorld(seedAmount, seedAmount, seedAmount);
             return;
         }
-        if (enabledColors[WHITE] && GetProportionWhite() < whiteBoost) ground.proportion[WHITE] = whiteBoost;
-        if (enabledColors[BLACK] && GetProportionBlack() < blackBoost) ground.proportion[BLACK] = blackBoost;
-        if (enabledColors[GRAY] && GetProportionGray() < grayBoost) ground.proportion[GRAY] = grayBoost;
+        float seedAmount = seeder.GetPolicy().flatSeedAmount;
+        if (enabledColors[WHITE] && GetProportionWhite() < seedAmount) ground.proportion[WHITE] = seedAmount;
+        if (enabledColors[BLACK] && GetProportionBlack() < seedAmount) ground.proportion[BLACK] = seedAmount;
+        if (enabledColors[GRAY] && GetProportionGray() < seedAmount) ground.proportion[GRAY] = seedAmount;
     }
 };
 
+/**
+ * The Daisyworld system computed in ordinary floats
+ */
+using World = DaisyWorld<float>;
+
 #endif
@@ -1,4 +1,35 @@
 #include "World.h"
+#include "Sweep.h"
+#include "Calibration.h"
+#include "Basin.h"
+#include "TippingPoints.h"
+#include "Hysteresis.h"
+#include "Figures.h"
+#include "Bifurcation.h"
+#include "Equilibrium.h"
+#include "Multigrid.h"
+#include "Precision.h"
+#include <chrono>
+#include <random>
+
+/**
+ * Times work that repeats something many times
+ * @returns how long the work takes, in nanoseconds per repetition
+ */
+template <typename Work>
+double NanosecondsPerRepetition(double repetitions, Work work) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+/**
+ * Runs a world for a number of updates
+ * @returns how long the updates took, in nanoseconds per update
+ */
+double NanosecondsPerUpdate(World& world, int updates) {
+    return NanosecondsPerRepetition(updates, [&]() { world.UpdateN(updates); });
+}
 
 /**
  * Test whether the world correctly calculates its global temperature based on the proportion of daisies
@@ -29,9 +60,7 @@ void TestConstantLuminosityOnlyBlack() {
     world.SetupDataFile("data/constant_luminosity_black.csv").SetTimingRepeat(world.GetUpdatesPerTimeUnit());
 
     // update the world for 100 time units
-    for (int i=0; i<world.GetUpdatesPerTimeUnit() * 100 + 1; i++) {
-        world.Update();
-    }
+    world.UpdateN(world.GetUpdatesPerTimeUnit() * 100 + 1);
 
     std::cout << "Black test completed. Temperature = " << std::to_string(world.GetGlobalTemperature()) << "; black daisy proportion = " << std::to_string(world.GetProportionBlack()) << std::endl;
 }
@@ -50,41 +79,17 @@ void TestConstantLuminosityBlackAndWhite() {
     world.SetupDataFile("data/constant_luminosity_black_and_white.csv").SetTimingRepeat(world.GetUpdatesPerTimeUnit());
     
     // update the world for 100 time units
-    for (int i=0; i<world.GetUpdatesPerTimeUnit() * 100 + 1; i++) {
-        world.Update();
-    }
+    world.UpdateN(world.GetUpdatesPerTimeUnit() * 100 + 1);
 
     std::cout << "Black and white test completed. Temperature = " << std::to_string(world.GetGlobalTemperature()) << "; black daisy proportion = " << std::to_string(world.GetProportionBlack()) << "; white daisy proportion = " << std::to_string(world.GetProportionWhite()) << std::endl;
 }
 
-/**
- * Run the Update method on a world updates times
- * @param world The world
- * @param updates How many times to call the update function
- */
-void UpdateWorldTimes(World& world, int updates) {
-    for (int update = 0; update < updates; update++) {
-        world.Update();
-        // boost the daisies halfway through to allow them to respond to other types of daisies growing
-        if (update == updates / 2) world.BoostDaisiesIfExtinct();
-    }
-}
-
-/**
- * Updates the world's luminosity, makes sure daisies are not extinct, and updates the world for updates steps
- * @param world The world
- * @param luminosity The dimensionless luminosity to test at
- * @param updates Number of updates to run at this luminosity
- */
-void TestWorldAtLuminosity(World& world, float luminosity, int updates) {
-    world.SetSolarLuminosity(luminosity);
-    world.BoostDaisiesIfExtinct();
-    UpdateWorldTimes(world, updates);
-}
-
 /**
  * Test as the solar luminosity rises and falls. Carresponds to graphs (b), (c), and (d) of Daisyworld paper.
- * Outputs what proportion of daisies and temperature the system stabilized at for each luminosity
+ * Outputs what proportion of daisies and temperature the system stabilized at for each luminosity, a log of
+ * extinctions, recoveries, and temperature excursions to a matching _events.csv file, and a summary of the hysteresis
+ * loop to a matching _hysteresis.csv file. On a round world, saves the cover at every latitude at each luminosity to a
+ * matching _latitudes.bin file. Draws the sweep, and on a round world where each color grows, as SVG figures in figures/
  * @param whiteEnabled whether to allow white daisies to grow
  * @param blackEnabled whether to allow black daisies to grow
  * @param outputFile name of file to output data to
@@ -94,8 +99,9 @@ void TestWorldAtLuminosity(World& world, float luminosity, int updates) {
  * @param timePerLuminosity how long in time units to allow the world to stabilize after the luminosity has changed
  * @param grayEnabled whether to allow gray daisies to grow
  * @param roundWorld whether to have different daisy populations and sunlight at different latitudes of the world
+ * @param includeStability whether to record the leading eigenvalue of the growth Jacobian and recovery time at each luminosity
  */
-void TestRaisingAndLoweringLuminosity(bool whiteEnabled, bool blackEnabled, std::string outputFile, float minLuminosity = 0.5, float maxLuminosity = 1.7, float luminosityStep = 0.01, int timePerLuminosity = 500, bool grayEnabled = false, bool roundWorld = false) {
+void TestRaisingAndLoweringLuminosity(bool whiteEnabled, bool blackEnabled, std::string outputFile, float minLuminosity = 0.5, float maxLuminosity = 1.7, float luminosityStep = 0.01, int timePerLuminosity = 500, bool grayEnabled = false, bool roundWorld = false, bool includeStability = false) {
     // setup world with the first luminosity value
     // when all 3 are enabled, each starts with 0.33, otherwise, each starts with 0.5 as long as it's enabled
     World world(whiteEnabled ? 0.33 : 0.0, blackEnabled ? 0.33 : 0.0, minLuminosity, grayEnabled ? 0.33 : 0.0, roundWorld);
@@ -106,24 +112,547 @@ void TestRaisingAndLoweringLuminosity(bool whiteEnabled, bool blackEnabled, std:
     // how many updates to do before switching the luminosity
     int updatesPerLuminosity = timePerLuminosity * world.GetUpdatesPerTimeUnit();
     // record data once per luminosity, at the last update where the world is that luminosity
-    world.SetupDataFile(outputFile).SetTimingRepeat(updatesPerLuminosity);
+    world.SetupDataFile(outputFile, includeStability).SetTimingRepeat(updatesPerLuminosity);
+    EventDetector events;
+    events.Observe(world);
+    // the state at the end of each luminosity, for the hysteresis summary and figures
+    std::vector<SweepPoint<float>> points;
+    int numberOfLuminosityTrials = std::round((maxLuminosity - minLuminosity) / luminosityStep);
+    // on a round world, the cover at every latitude at the end of each luminosity
+    LatitudeProfileRecorder profiles(roundWorld ? 2 * numberOfLuminosityTrials + 1 : 0, world.GetNumberOfLatitudes());
     // give the world one update so that the data file records on the last update that the world is each luminosity
     world.Update();
+    events.Observe(world);
     // raise the luminosity from minLuminosity to maxLuminosity
-    int numberOfLuminosityTrials = std::round((maxLuminosity - minLuminosity) / luminosityStep);
     for (int trial = 0; trial < numberOfLuminosityTrials; trial++) {
         float luminosity = minLuminosity + luminosityStep * trial;
-        TestWorldAtLuminosity(world, luminosity, updatesPerLuminosity);
+        TestWorldAtLuminosity(world, luminosity, updatesPerLuminosity, &events);
+        points.push_back(RecordSweepPoint(world, true));
+        profiles.Record(world, true);
     }
     // lower the luminosity from maxLuminosity to minLuminosity
     for (int trial = numberOfLuminosityTrials; trial >= 0; trial--) {
         float luminosity = minLuminosity + luminosityStep * trial;
-        TestWorldAtLuminosity(world, luminosity, updatesPerLuminosity);
+        TestWorldAtLuminosity(world, luminosity, updatesPerLuminosity, &events);
+        points.push_back(RecordSweepPoint(world, false));
+        profiles.Record(world, false);
+    }
+    std::string outputName = outputFile.substr(0, outputFile.rfind(".csv"));
+    events.WriteLog(outputName + "_events.csv");
+    HysteresisAnalyzer hysteresis;
+    hysteresis.AddAll(points);
+    hysteresis.Summarize().Write(outputName + "_hysteresis.csv");
+    // draw the figures straight from the sweep, named after the data file
+    std::string figureName = "figures/" + outputName.substr(outputName.rfind('/') + 1);
+    bool enabled[World::COLORS] = {whiteEnabled, blackEnabled, grayEnabled};
+    WriteSweepFigure(figureName + ".svg", points, enabled);
+    if (roundWorld) {
+        profiles.Save(outputName + "_latitudes.bin");
+        WriteLatitudeHeatmap(figureName + "_lat_lum.svg", profiles);
     }
 
     std::cout << "Raising and lowering luminosity test completed." << std::endl;
 }
 
+/**
+ * Test how sensitive the steady state of a black and white Daisyworld is to the model's parameters. Derivatives are
+ * computed with forward-mode automatic differentiation in the same run as the values, rather than by finite differences,
+ * and checked against central differences of float runs.
+ * @param luminosity The dimensionless solar luminosity to find the steady state at
+ * @param timeUnits How long in time units to allow the world to stabilize
+ */
+void TestSensitivityToParameters(float luminosity = 1.0, int timeUnits = 500) {
+    // the parameters being differentiated with respect to
+    enum { DEATH_RATE, WHITE_ALBEDO, BLACK_ALBEDO, CONDUCTIVITY, LUMINOSITY, PARAMETERS };
+    const std::string parameterNames[PARAMETERS] = {"deathRate", "whiteAlbedo", "blackAlbedo", "conductivityConstant", "luminosity"};
+    using Scalar = Dual<PARAMETERS>;
+
+    DaisyWorld<Scalar> world(0.33, 0.33, Scalar::Parameter(luminosity, LUMINOSITY));
+    world.SetDeathRate(Scalar::Parameter(0.3, DEATH_RATE));
+    world.SetFlowerAlbedo(World::WHITE, Scalar::Parameter(0.75, WHITE_ALBEDO));
+    world.SetFlowerAlbedo(World::BLACK, Scalar::Parameter(0.25, BLACK_ALBEDO));
+    world.SetConductivityConstant(Scalar::Parameter(20, CONDUCTIVITY));
+
+    world.UpdateN(world.GetUpdatesPerTimeUnit() * timeUnits);
+
+    Scalar temperature = world.GetGlobalTemperature();
+    Scalar white = world.GetProportionWhite();
+    Scalar black = world.GetProportionBlack();
+    std::cout << "Sensitivity test completed. Temperature = " << std::to_string(temperature.value) << "; white daisy proportion = " << std::to_string(white.value) << "; black daisy proportion = " << std::to_string(black.value) << std::endl;
+    for (int i=0; i<PARAMETERS; i++) {
+        std::cout << "d/d(" << parameterNames[i] << "): temp " << std::to_string(temperature.Derivative(i)) << ", a_w " << std::to_string(white.Derivative(i)) << ", a_b " << std::to_string(black.Derivative(i)) << std::endl;
+    }
+
+    // the same steady state in floats, with the parameters in the same order
+    const float parameters[PARAMETERS] = {0.3, 0.75, 0.25, 20, luminosity};
+    auto steadyState = [&](const float (&values)[PARAMETERS], float (&outputs)[3]) {
+        World floatWorld(0.33, 0.33, values[LUMINOSITY]);
+        floatWorld.SetDeathRate(values[DEATH_RATE]);
+        floatWorld.SetFlowerAlbedo(World::WHITE, values[WHITE_ALBEDO]);
+        floatWorld.SetFlowerAlbedo(World::BLACK, values[BLACK_ALBEDO]);
+        floatWorld.SetConductivityConstant(values[CONDUCTIVITY]);
+        floatWorld.UpdateN(floatWorld.GetUpdatesPerTimeUnit() * timeUnits);
+        outputs[0] = floatWorld.GetGlobalTemperature();
+        outputs[1] = floatWorld.GetProportionWhite();
+        outputs[2] = floatWorld.GetProportionBlack();
+    };
+    double largestDerivative = 0.0, largestDifference = 0.0;
+    for (int i=0; i<PARAMETERS; i++) {
+        // a step of 1% of the parameter, small enough for the curvature and large enough for float rounding
+        float step = 0.01f * parameters[i];
+        float values[PARAMETERS], above[3], below[3];
+        std::copy(parameters, parameters + PARAMETERS, values);
+        values[i] = parameters[i] + step;
+        steadyState(values, above);
+        values[i] = parameters[i] - step;
+        steadyState(values, below);
+        const Scalar* outputs[3] = {&temperature, &white, &black};
+        for (int output = 0; output < 3; output++) {
+            double centralDifference = (above[output] - below[output]) / (2.0 * step);
+            largestDerivative = std::max(largestDerivative, std::abs((double)outputs[output]->Derivative(i)));
+            largestDifference = std::max(largestDifference, std::abs(centralDifference - outputs[output]->Derivative(i)));
+        }
+    }
+    std::cout << "Largest derivative " << largestDerivative << ", largest difference from central differences " << largestDifference << std::endl;
+}
+
+/**
+ * Test whether calibration recovers the model's parameters from one of its own data files. Starts from a wrong death
+ * rate and white albedo and fits them to the white daisy sweep, with both a gradient-based and a derivative-free optimizer.
+ * @param targetFile The data file written by the white daisy sweep test
+ */
+void TestCalibration(std::string targetFile = "data/white.csv") {
+    // a coarser and shorter sweep than the one that wrote the target, which still lands on its luminosities
+    SweepSettings settings;
+    settings.blackEnabled = false;
+    settings.luminosityStep = 0.05;
+    settings.timePerLuminosity = 100;
+    CalibrationTarget target = CalibrationTarget::LoadFromFile(targetFile, {"a_w", "temp"}, {1.0, 0.001});
+    std::vector<int> fittedParameters = {ModelParameters::DEATH_RATE, ModelParameters::WHITE_ALBEDO};
+    ModelParameters initialParameters;
+    initialParameters.values[ModelParameters::DEATH_RATE] = 0.25;
+    initialParameters.values[ModelParameters::WHITE_ALBEDO] = 0.7;
+
+    CalibrationResult levenbergMarquardt = Calibrator(settings, target, fittedParameters, initialParameters).LevenbergMarquardt();
+    std::cout << "Levenberg-Marquardt calibration completed. deathRate = " << std::to_string(levenbergMarquardt.parameters.values[ModelParameters::DEATH_RATE]) << "; whiteAlbedo = " << std::to_string(levenbergMarquardt.parameters.values[ModelParameters::WHITE_ALBEDO]) << "; loss = " << std::to_string(levenbergMarquardt.loss) << "; sweeps = " << levenbergMarquardt.evaluations << std::endl;
+    CalibrationResult nelderMead = Calibrator(settings, target, fittedParameters, initialParameters).NelderMead();
+    std::cout << "Nelder-Mead calibration completed. deathRate = " << std::to_string(nelderMead.parameters.values[ModelParameters::DEATH_RATE]) << "; whiteAlbedo = " << std::to_string(nelderMead.parameters.values[ModelParameters::WHITE_ALBEDO]) << "; loss = " << std::to_string(nelderMead.loss) << "; sweeps = " << nelderMead.evaluations << std::endl;
+}
+
+/**
+ * Test how the policy for reseeding extinct daisies changes the range of luminosities where white daisies survive.
+ * Each policy runs its own sweep, in parallel.
+ */
+void TestSeedingPolicies() {
+    const std::string names[5] = {"boost at each luminosity and halfway", "periodic every 10 time units", "1 time unit after extinction", "random immigration", "round world with dispersal"};
+    SeedingPolicy policies[5] = {SeedingPolicy(), SeedingPolicy::Periodic(1000), SeedingPolicy::OnExtinction(100), SeedingPolicy::Immigration(0.001, 0.01), SeedingPolicy::Dispersal(1.0)};
+    std::vector<SweepPoint<float>> results[5];
+    RunBatch(5, [&](int i) {
+        SweepSettings settings;
+        settings.blackEnabled = false;
+        settings.luminosityStep = 0.02;
+        settings.timePerLuminosity = 200;
+        settings.roundWorld = i == 4;
+        settings.seeding = policies[i];
+        results[i] = RunLuminositySweep(settings);
+    });
+    for (int i=0; i<5; i++) {
+        // the lowest and highest luminosities where white daisies cover at least 1% of the planet, on each part of the sweep
+        float lowest[2] = {INFINITY, INFINITY}, highest[2] = {-INFINITY, -INFINITY};
+        for (const SweepPoint<float>& point : results[i]) {
+            if (point.proportion[World::WHITE] < 0.01) continue;
+            lowest[point.rising] = std::min(lowest[point.rising], point.luminosity);
+            highest[point.rising] = std::max(highest[point.rising], point.luminosity);
+        }
+        std::cout << "Seeding policy " << names[i] << ": white daisies survive from " << lowest[1] << " to " << highest[1] << " rising, " << lowest[0] << " to " << highest[0] << " falling" << std::endl;
+    }
+}
+
+/**
+ * Test which starting covers of black and white daisies lead to which final state, at luminosities where several states
+ * may be stable. Writes one basin map per luminosity.
+ */
+void TestBasinsOfAttraction() {
+    BasinSettings settings;
+    settings.luminosities = {0.7, 1.0, 1.3, 1.45};
+    std::vector<BasinMap> maps = MapBasinsOfAttraction(settings);
+    for (const BasinMap& map : maps) {
+        map.Write("data/basins_black_and_white_" + std::to_string(std::lround(map.luminosity * 100)) + ".csv");
+        std::cout << "Basins at luminosity " << map.luminosity << ":";
+        for (BasinMap::State state = 0; state < 1 << World::COLORS; state++) {
+            if (map.Fraction(state) > 0.0f) std::cout << " " << BasinMap::StateName(state) << " " << map.Fraction(state);
+        }
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * Test whether a sweep with adaptive luminosity steps finds the same curve as the uniform sweep with fewer luminosities,
+ * for white daisies
+ */
+void TestAdaptiveSweep() {
+    SweepSettings settings;
+    settings.blackEnabled = false;
+    std::vector<SweepPoint<float>> uniform = RunLuminositySweep(settings);
+    int plateaus;
+    std::vector<SweepPoint<float>> adaptive = RunAdaptiveLuminositySweep(settings, AdaptiveStepSettings(), &plateaus);
+    for (const std::vector<SweepPoint<float>>* points : {&uniform, &adaptive}) {
+        // the highest luminosity where white daisies cover at least 1% of the planet while the luminosity rises
+        float collapse = -INFINITY;
+        for (const SweepPoint<float>& point : *points) {
+            if (point.rising && point.proportion[World::WHITE] >= 0.01) collapse = std::max(collapse, point.luminosity);
+        }
+        std::cout << (points == &uniform ? "Uniform" : "Adaptive") << " sweep: " << points->size() << " points; white daisies collapse after " << collapse << std::endl;
+    }
+    std::cout << "The adaptive sweep ran " << plateaus << " luminosities, including rejected steps" << std::endl;
+}
+
+/**
+ * Test finding the luminosities where black and white daisies appear and collapse, by bisection from a coarse sweep
+ */
+void TestTippingPoints() {
+    TippingPointSettings settings;
+    settings.sweep.luminosityStep = 0.05;
+    for (const TippingPoint& tippingPoint : LocateTippingPoints(settings)) {
+        std::cout << "Tipping point: " << tippingPoint.Describe() << " at " << std::to_string(tippingPoint.luminosity) << std::endl;
+    }
+}
+
+/**
+ * Test how the death rate of daisies changes the range of luminosities where black and white daisies survive and regulate
+ * the temperature, by scanning luminosity against death rate
+ */
+void TestBifurcationScan() {
+    BifurcationSettings settings;
+    settings.sweep.luminosityStep = 0.02;
+    settings.sweep.timePerLuminosity = 200;
+    settings.parameterValues = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7};
+    BifurcationGrid grid = RunBifurcationScan(settings);
+    grid.Write("data/bifurcation_death_rate.csv");
+    for (size_t i = 0; i < grid.parameterValues.size(); i++) {
+        // the range of rising luminosities where any daisies survive, and where the temperature is regulated
+        float survival[2] = {INFINITY, -INFINITY}, regulated[2] = {INFINITY, -INFINITY};
+        for (size_t j = 0; j < grid.points[i].size(); j++) {
+            const SweepPoint<float>& point = grid.points[i][j];
+            if (!point.rising || grid.regimes[i][j] == 0) continue;
+            survival[0] = std::min(survival[0], point.luminosity);
+            survival[1] = std::max(survival[1], point.luminosity);
+            if (!(grid.regimes[i][j] & BifurcationGrid::REGULATED)) continue;
+            regulated[0] = std::min(regulated[0], point.luminosity);
+            regulated[1] = std::max(regulated[1], point.luminosity);
+        }
+        std::cout << "Death rate " << grid.parameterValues[i] << ": daisies survive from " << survival[0] << " to " << survival[1] << ", temperature regulated from " << regulated[0] << " to " << regulated[1] << std::endl;
+    }
+}
+
+/**
+ * Test whether solving for the steady states of the single color sweeps of tests 5, 6, and 8 matches running them, and
+ * how much faster it is
+ */
+void TestAnalyticSteadyStates() {
+    const std::string names[World::COLORS] = {"White", "Black", "Gray"};
+    for (int color = 0; color < World::COLORS; color++) {
+        SweepSettings settings;
+        settings.whiteEnabled = color == World::WHITE;
+        settings.blackEnabled = color == World::BLACK;
+        settings.grayEnabled = color == World::GRAY;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SweepPoint<float>> simulated = RunLuminositySweep(settings);
+        auto simulatedEnd = std::chrono::steady_clock::now();
+        settings.solveAnalytically = true;
+        std::vector<SweepPoint<float>> solved = RunLuminositySweep(settings);
+        auto solvedEnd = std::chrono::steady_clock::now();
+        // the largest difference in cover between running the world and solving for its steady states
+        float difference = 0.0;
+        for (size_t i = 0; i < simulated.size(); i++) {
+            difference = std::max(difference, std::abs(simulated[i].proportion[color] - solved[i].proportion[color]));
+        }
+        std::cout << names[color] << " daisies: largest difference in cover " << difference << "; simulated in " << std::chrono::duration<double>(simulatedEnd - start).count() << " s, solved in " << std::chrono::duration<double>(solvedEnd - simulatedEnd).count() << " s" << std::endl;
+    }
+}
+
+/**
+ * Test how long one update takes for each configuration of the world, through its specialized update kernel
+ */
+void TestUpdateSpeed() {
+    for (bool roundWorld : {false, true}) {
+        for (int colors = 1; colors < 1 << World::COLORS; colors++) {
+            World world(0.33, 0.33, 1.0, 0.33, roundWorld);
+            world.SetWhiteEnabled(colors & (1 << World::WHITE));
+            world.SetBlackEnabled(colors & (1 << World::BLACK));
+            world.SetGrayEnabled(colors & (1 << World::GRAY));
+            // round updates take about as long as one flat update per latitude
+            int updates = roundWorld ? 20000 : 1000000;
+            double nanoseconds = NanosecondsPerUpdate(world, updates);
+            std::string name = (roundWorld ? "Round" : "Flat") + std::string(" world with ") + BasinMap::StateName(colors) + " daisies";
+            std::cout << name << ": " << nanoseconds << " ns per update" << std::endl;
+        }
+    }
+}
+
+/**
+ * Test how the latitudinal conduction of a round world changes where its black and white daisies grow, and how long its
+ * updates take
+ */
+void TestLatitudinalConduction() {
+    for (float conduction : {0.0f, 0.25f, 0.5f, 1.0f}) {
+        World world(0.33, 0.33, 1.0, 0.0, true);
+        world.SetLatitudinalConduction(conduction);
+        double nanoseconds = NanosecondsPerUpdate(world, 20000);
+        // the mean internal latitude of each color, weighted by its cover, from 0 at the pole
+        float meanLatitude[World::COLORS] = {};
+        for (int color : {World::WHITE, World::BLACK}) {
+            float cover = 0.0;
+            for (int latitude = 0; latitude < world.GetNumberOfLatitudes(); latitude++) {
+                cover += world.GetProportionAtInternalLatitude(color, latitude);
+                meanLatitude[color] += latitude * world.GetProportionAtInternalLatitude(color, latitude);
+            }
+            if (cover > 0) meanLatitude[color] /= cover;
+        }
+        std::cout << "Conduction " << conduction << ": white " << world.GetProportionWhite() << " at latitude " << meanLatitude[World::WHITE] << ", black " << world.GetProportionBlack() << " at latitude " << meanLatitude[World::BLACK] << ", " << world.GetGlobalTemperature() << " C; " << nanoseconds << " ns per update" << std::endl;
+        if (conduction == 0.5f) {
+            // check the growth Jacobian against central differences of one update, which moves the cover by its growth
+            // rate times the time per update, on the latitudes where daisies grow
+            GrowthJacobian jacobian = world.GetGrowthJacobian();
+            std::vector<double> cover = world.GetCoverVector();
+            World::State state = world.SaveState();
+            double timePerUpdate = 1.0 / world.GetUpdatesPerTimeUnit();
+            double step = 0.01;
+            double largestEntry = 0.0, largestDifference = 0.0;
+            for (int column = 0; column < jacobian.Size(); column++) {
+                if (cover[column] < 2 * step) continue;
+                std::vector<double> updated[2];
+                for (int side = 0; side < 2; side++) {
+                    std::vector<double> perturbed = cover;
+                    perturbed[column] += side ? step : -step;
+                    world.SetCoverVector(perturbed);
+                    world.Update();
+                    updated[side] = world.GetCoverVector();
+                    world.RestoreState(state);
+                }
+                for (int row = 0; row < jacobian.Size(); row++) {
+                    if (cover[row] < 2 * step) continue;
+                    double finiteDifference = (updated[1][row] - updated[0][row] - (row == column ? 2 * step : 0.0)) / (2 * step * timePerUpdate);
+                    largestEntry = std::max(largestEntry, std::abs(jacobian.Entry(row, column)));
+                    largestDifference = std::max(largestDifference, std::abs(finiteDifference - jacobian.Entry(row, column)));
+                }
+            }
+            std::cout << "Growth Jacobian at conduction " << conduction << ": largest entry " << largestEntry << ", largest difference from finite differences " << largestDifference << std::endl;
+        }
+    }
+}
+
+/**
+ * Test how many updates relaxing worlds to equilibrium takes with Anderson acceleration, against running them until
+ * they stop changing
+ */
+void TestAndersonEquilibrium() {
+    struct Case {
+        bool roundWorld;
+        int colors;
+        float luminosity;
+    };
+    const Case cases[] = {{false, 3, 1.0}, {true, 1, 1.0}, {true, 3, 1.0}, {true, 3, 0.8}, {true, 7, 1.0}};
+    for (const Case& test : cases) {
+        EquilibriumResult results[2];
+        std::vector<double> equilibria[2];
+        double seconds[2];
+        for (bool accelerate : {false, true}) {
+            World world(0.33, 0.33, test.luminosity, 0.33, test.roundWorld);
+            world.SetWhiteEnabled(test.colors & (1 << World::WHITE));
+            world.SetBlackEnabled(test.colors & (1 << World::BLACK));
+            world.SetGrayEnabled(test.colors & (1 << World::GRAY));
+            world.SetSeedingPolicy(SeedingPolicy::WithoutSweepBoosts());
+            EquilibriumSettings settings;
+            settings.accelerate = accelerate;
+            settings.maxIterations = 20000;
+            auto start = std::chrono::steady_clock::now();
+            results[accelerate] = RelaxToEquilibrium(world, settings);
+            seconds[accelerate] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            equilibria[accelerate] = world.GetCoverVector();
+        }
+        // the largest difference in cover between the two equilibria
+        double difference = 0.0;
+        for (size_t i = 0; i < equilibria[0].size(); i++) difference = std::max(difference, std::abs(equilibria[0][i] - equilibria[1][i]));
+        std::string name = (test.roundWorld ? "Round" : "Flat") + std::string(" world with ") + BasinMap::StateName(test.colors) + " daisies at luminosity " + std::to_string(test.luminosity).substr(0, 3);
+        std::cout << name << ": plain updates " << results[0].updates << (results[0].converged ? "" : " (not converged)") << " in " << seconds[0] << " s, Anderson " << results[1].updates << (results[1].converged ? "" : " (not converged)") << " in " << seconds[1] << " s, difference in cover " << difference << std::endl;
+    }
+}
+
+/**
+ * Test how long finding the equilibrium of a round black and white world takes at higher and higher resolutions, by
+ * solving on coarse grids of latitudes first, against solving on the finest grid from the start
+ */
+void TestLatitudeMultigrid() {
+    for (int latitudes : {1000, 10000, 100000}) {
+        for (bool direct : {false, true}) {
+            // solving directly on the finest grid takes too long past 10000 latitudes
+            if (direct && latitudes > 10000) continue;
+            World world(0.33, 0.33, 1.0, 0.0, true);
+            MultigridSettings settings;
+            settings.latitudes = latitudes;
+            if (direct) settings.coarsestLatitudes = latitudes;
+            auto start = std::chrono::steady_clock::now();
+            MultigridResult result = SolveLatitudeMultigrid(world, settings);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double cover[2] = {};
+            for (int latitude = 0; latitude < result.latitudes; latitude++) {
+                for (int a = 0; a < 2; a++) cover[a] += result.cover[latitude * 2 + a] / result.latitudes;
+            }
+            std::cout << latitudes << " latitudes " << (direct ? "directly" : "from coarse grids") << ": " << seconds << " s, " << result.levels.back().relaxation.iterations << " iterations on the finest grid" << (result.Converged() ? "" : " (not converged)") << ", white " << cover[0] << ", black " << cover[1] << std::endl;
+        }
+    }
+}
+
+/**
+ * Test how exact and how fast each way of averaging over many latitudes is, against a long double reference, on the
+ * sunlight absorbed by latitudes of random albedos, and on the imbalance of each latitude against that average, which
+ * nearly cancels out like the imbalances of an energy budget
+ */
+void TestSummation() {
+    std::mt19937 generator(361);
+    for (int latitudes : {90, 10000, 1000000}) {
+        std::vector<float> absorbed(latitudes);
+        long double reference = 0.0;
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            float multiplier = 0.6 + 0.9 * latitude / (latitudes - 1);
+            absorbed[latitude] = multiplier * std::uniform_real_distribution<float>(0.25, 0.75)(generator);
+            reference += absorbed[latitude];
+        }
+        reference /= latitudes;
+        // the average of the imbalances is tiny next to the imbalances themselves, so it shows the rounding errors of the
+        // additions, which are lost in the last rounding of an average of positive terms
+        std::vector<float> imbalance(latitudes);
+        long double imbalanceReference = 0.0;
+        for (int latitude = 0; latitude < latitudes; latitude++) {
+            imbalance[latitude] = absorbed[latitude] - (float)reference;
+            imbalanceReference += imbalance[latitude];
+        }
+        imbalanceReference /= latitudes;
+        // enough repetitions for each sum to take a measurable time
+        int repetitions = 100000000 / latitudes;
+        auto measure = [&](const std::string& name, auto average) {
+            float result = 0.0;
+            double nanoseconds = NanosecondsPerRepetition((double)repetitions * latitudes, [&]() {
+                for (int i = 0; i < repetitions; i++) {
+                    result = average(absorbed);
+                    // keep the sum from being hoisted out of the loop
+                    asm volatile("" : : "r"(&result) : "memory");
+                }
+            });
+            float imbalanceResult = average(imbalance);
+            std::cout << latitudes << " latitudes, " << name << ": relative error " << std::abs((result - reference) / reference) << ", " << nanoseconds << " ns per latitude; relative error of the average imbalance " << std::abs((imbalanceResult - imbalanceReference) / imbalanceReference) << std::endl;
+        };
+        measure("one at a time", [&](const std::vector<float>& terms) {
+            float total = 0.0;
+            for (int latitude = 0; latitude < latitudes; latitude++) total += terms[latitude] / latitudes;
+            return total;
+        });
+        measure("pairwise", [&](const std::vector<float>& terms) { return PairwiseSum(terms.data(), latitudes) / latitudes; });
+        measure("compensated", [&](const std::vector<float>& terms) { return CompensatedSum(terms.data(), latitudes) / latitudes; });
+    }
+}
+
+/**
+ * Test how fast and how exact running a round world with many latitudes is with its cover stored in doubles, floats,
+ * and 16 bit fixed point, against the cover stored in doubles
+ */
+void TestMixedPrecision() {
+    // at the world's own 90 latitudes, a profile follows the same physics as the world's update kernels
+    for (float conduction : {0.0f, 0.5f}) {
+        for (int updates : {1, 3000}) {
+            World world(0.33, 0.33, 1.0, 0.0, true);
+            world.SetLatitudinalConduction(conduction);
+            std::vector<double> profile = world.GetCoverVector();
+            world.UpdateLatitudeProfile(profile, profile.size() / 2, updates);
+            world.UpdateN(updates);
+            std::vector<double> updated = world.GetCoverVector();
+            double largestDifference = 0.0;
+            for (size_t i = 0; i < profile.size(); i++) largestDifference = std::max(largestDifference, std::abs(profile[i] - updated[i]));
+            std::cout << "90 latitude profile at conduction " << conduction << " after " << updates << " updates: largest difference from World::UpdateN " << largestDifference << std::endl;
+        }
+    }
+    World world(0.33, 0.33, 1.0, 0.0, true);
+    std::vector<double> worldCover = world.GetCoverVector();
+    int updates = 500;
+    for (int latitudes : {10000, 1000000}) {
+        std::vector<double> start = ResampleLatitudeProfile(worldCover, 2, worldCover.size() / 2, latitudes);
+        std::vector<double> reference;
+        auto measure = [&](const std::string& name, auto stored) {
+            using Stored = typename decltype(stored)::value_type;
+            stored.resize(start.size());
+            for (size_t i = 0; i < start.size(); i++) stored[i] = StoreProportion<Stored>(start[i], RoundingNoise(i, 0));
+            double nanoseconds = NanosecondsPerRepetition((double)updates * latitudes, [&]() { world.UpdateLatitudeProfile(stored, latitudes, updates); });
+            std::vector<double> proportions(stored.begin(), stored.end());
+            if (reference.empty()) reference = proportions;
+            // the largest error at any latitude, and the error of the cover of the whole planet
+            double largestError = 0.0;
+            double coverError = 0.0;
+            for (size_t i = 0; i < proportions.size(); i++) {
+                largestError = std::max(largestError, std::abs(proportions[i] - reference[i]));
+                coverError += (proportions[i] - reference[i]) / latitudes;
+            }
+            std::cout << latitudes << " latitudes, " << name << " (" << sizeof(Stored) << " bytes): " << nanoseconds << " ns per latitude per update, largest error " << largestError << ", cover error " << std::abs(coverError) << std::endl;
+        };
+        measure("double", std::vector<double>());
+        measure("float", std::vector<float>());
+        measure("fixed point", std::vector<FixedProportion16>());
+    }
+}
+
+/**
+ * Test how fast a round world runs while its only color of daisy dies out, when its proportions are allowed to decay
+ * into subnormal floats, when subnormals are flushed to zero, and when the default extinction threshold clamps them
+ */
+void TestSubnormalProtection() {
+    for (int mode = 0; mode < 3; mode++) {
+        float extinctionThreshold = mode == 2 ? 0.001 : 0.0;
+        bool flushSubnormals = mode == 1;
+        double meanNanoseconds = 0.0, slowestNanoseconds = 0.0;
+        float finalProportion = 0.0;
+        RunBatch(1, [&](int) {
+            // black daisies die out at this luminosity
+            World world(0.0, 0.5, 0.6, 0.0, true);
+            world.SetSeedingPolicy(SeedingPolicy::WithoutSweepBoosts());
+            world.SetExtinctionThreshold(extinctionThreshold);
+            int windows = 50, updatesPerWindow = 1000;
+            for (int window = 0; window < windows; window++) {
+                double nanoseconds = NanosecondsPerUpdate(world, updatesPerWindow);
+                meanNanoseconds += nanoseconds / windows;
+                slowestNanoseconds = std::max(slowestNanoseconds, nanoseconds);
+            }
+            finalProportion = world.GetProportionBlack();
+        }, 1, flushSubnormals);
+        std::string name = mode == 0 ? "without a threshold" : mode == 1 ? "flushing subnormals to zero" : "with an extinction threshold of 0.001";
+        std::cout << name << ": " << meanNanoseconds << " ns per update on average, " << slowestNanoseconds << " ns at the slowest, black daisies end at " << finalProportion << std::endl;
+    }
+}
+
+/**
+ * Test the energy budget of a round world with white and black daisies, without and with latitudinal conduction,
+ * how much tracking it slows down updates, and write the budget of the run with conduction to energy_budget_round.csv
+ */
+void TestEnergyBudget() {
+    for (float conduction : {0.0f, 0.5f}) {
+        World world(0.33, 0.33, 1.0, 0.0, true);
+        world.SetLatitudinalConduction(conduction);
+        if (conduction > 0.0f) world.SetupDataFile("data/energy_budget_round.csv", false, true).SetTimingRepeat(world.GetUpdatesPerTimeUnit());
+        else world.SetEnergyBudgetTracking(true);
+        world.UpdateN(5000);
+        World::EnergyBudget budget = world.TakeEnergyBudget();
+        std::cout << "conduction " << conduction << ": absorbed " << budget.absorbed << " W/m^2, emitted " << budget.emitted << " W/m^2, imbalance " << budget.Imbalance() << " W/m^2" << std::endl;
+        std::cout << "imbalance from the equator to the pole:";
+        for (int band = 0; band < 10; band++) std::cout << " " << budget.BandImbalance(band);
+        std::cout << std::endl;
+    }
+    for (bool tracking : {false, true}) {
+        World world(0.33, 0.33, 1.0, 0.0, true);
+        world.SetEnergyBudgetTracking(tracking);
+        double nanoseconds = NanosecondsPerUpdate(world, 20000);
+        std::cout << (tracking ? "with" : "without") << " the energy budget: " << nanoseconds << " ns per update" << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     std::cout << "Test 1" << std::endl;
     // Test 1: make sure that the world can correctly calculate temperature based on the amount of daisies in it
@@ -201,4 +730,136 @@ int main(int argc, char* argv[]) {
     std::cout << "Test 14" << std::endl;
     // Test 14 (extension 1+2): A round world with white, black, and gray daisies.
     TestRaisingAndLoweringLuminosity(true, true, "data/white_black_and_gray_round.csv", 0.5, 1.7, 0.01, 500, true, true);
+
+    std::cout << "Test 15" << std::endl;
+    // Test 15: how sensitive is the steady state of the black and white world at luminosity 1 to each model parameter?
+    // Expected output: raising the luminosity barely changes the temperature (daisies regulate it) but shifts cover
+    // from black to white daisies. Every derivative matches central differences of float runs to within about 0.01,
+    // against derivatives up to about 11.
+    TestSensitivityToParameters();
+
+    std::cout << "Test 16" << std::endl;
+    // Test 16: can calibration recover the default death rate (0.3) and white albedo (0.75) from the white daisy sweep?
+    // Expected output: both optimizers return parameters close to the defaults with a loss near 0.
+    TestCalibration();
+
+    std::cout << "Test 17" << std::endl;
+    // Test 17: how much do the results depend on the way extinct daisies are reseeded?
+    // Expected output: on a flat world the range where white daisies survive barely depends on the policy, so the hysteresis
+    // is not an artifact of the boosts. Random immigration widens the range slightly.
+    TestSeedingPolicies();
+
+    std::cout << "Test 18" << std::endl;
+    // Test 18: how stable is each steady state of the black and white world, and how quickly does it recover from a disturbance?
+    // Expected output: lambda is negative wherever daisies are established, and rises towards 0 (long recovery times) as the
+    // luminosity approaches the points where the daisies suddenly die out, warning of the tipping points ahead.
+    TestRaisingAndLoweringLuminosity(true, true, "data/black_and_white_stability.csv", 0.5, 1.7, 0.01, 500, false, false, true);
+
+    std::cout << "Test 19" << std::endl;
+    // Test 19: which starting covers of black and white daisies lead to which final state?
+    // Expected output: at luminosity 0.7 and 1.3, sparse starting covers die out while denser ones establish daisies, so the
+    // barren planet and the daisy-covered planet are both stable. At luminosity 1 nearly every start with both colors
+    // ends with them coexisting.
+    TestBasinsOfAttraction();
+
+    std::cout << "Test 20" << std::endl;
+    // Test 20: can the luminosity sweep spend its steps where the daisies change abruptly instead of uniformly?
+    // Expected output: the adaptive sweep runs about half as many luminosities as the uniform one, and places the collapse
+    // of the white daisies to within 0.001 (at about 1.561) instead of 0.01.
+    TestAdaptiveSweep();
+
+    std::cout << "Test 21" << std::endl;
+    // Test 21: exactly where do black and white daisies appear and collapse as the luminosity rises and falls?
+    // Expected output: while rising, black daisies appear at about 0.713 and white at 0.743, black collapse at 1.340 and
+    // white at 1.561. While falling, both reappear at 1.224, and the hysteresis shows as white collapsing at 0.743 but
+    // black holding on until 0.623.
+    TestTippingPoints();
+
+    std::cout << "Test 22" << std::endl;
+    // Test 22: how does the death rate of daisies change where they survive and regulate the temperature?
+    // Expected output: as the death rate rises from 0.1 to 0.7, the range where daisies survive while the luminosity rises
+    // shrinks from about 0.70-1.68 to 0.78-1.20, and the regulated range shrinks with it.
+    TestBifurcationScan();
+
+    std::cout << "Test 23" << std::endl;
+    // Test 23: do the steady states solved from equation (1) match the single color sweeps of tests 5, 6, and 8?
+    // Expected output: the cover differs by less than 0.002 at every luminosity, and the largest differences are next to
+    // tipping points where the running world has not quite settled. Solving is about 50 to 100 times faster.
+    TestAnalyticSteadyStates();
+
+    std::cout << "Test 24" << std::endl;
+    // Test 24: how long does one update take for each combination of enabled colors on flat and round worlds?
+    // Expected output: flat updates take around 100 ns whatever colors are enabled, since the global temperature dominates.
+    // Round updates take around 0.4 to 1.5 microseconds, growing with the number of enabled colors.
+    TestUpdateSpeed();
+
+    std::cout << "Test 25" << std::endl;
+    // Test 25: how does conducting heat between latitudes change where black and white daisies grow on a round world?
+    // Expected output: with more conduction each latitude sits closer to its own radiative temperature, so the equator
+    // heats and the poles cool, white daisies retreat from the equator, black daisies from the pole, and at full
+    // conduction both cover much less. Updates take about as long with conduction as without, since the temperature of
+    // each latitude is found once per step and shared by every color. At conduction 0.5 the growth Jacobian matches
+    // finite differences of one update to within about 1e-3, against entries up to about 0.8.
+    TestLatitudinalConduction();
+
+    std::cout << "Test 26" << std::endl;
+    // Test 26: how many fewer updates does Anderson acceleration need to bring a world to equilibrium?
+    // Expected output: 4 times fewer updates for the flat world (4000 against 1000), 6 times fewer for the round white
+    // world (35800 against 5800), and 65 to 95 times fewer for round black and white worlds (898800 against 13500 at
+    // luminosity 1, 872100 against 9200 at 0.8), whose slowest disturbance takes thousands of time units to die out. There the plain run
+    // stops up to 0.003 short of the equilibrium it is creeping toward. With all three colors the equilibrium is barely
+    // stable, so the plain run doesn't converge within 20000 time units and the two end in different places.
+    TestAndersonEquilibrium();
+
+    std::cout << "Test 27" << std::endl;
+    // Test 27: how does the time to find the equilibrium of a round world grow with the number of latitudes?
+    // Expected output: starting from the equilibrium of the grid before, the finest grid needs under 10 iterations
+    // instead of hundreds. At 1000 latitudes both take a fraction of a second, so multigrid only pays off from about
+    // 10^4 latitudes, where it takes about 0.2 s instead of over 10 s. From there the time grows a little faster than
+    // the number of latitudes. The cover settles at about 0.38 white and 0.31 black, as at 90 latitudes.
+    TestLatitudeMultigrid();
+
+    std::cout << "Test 28" << std::endl;
+    // Test 28: how exact and how fast is averaging over many latitudes by adding them one at a time, pairwise, and with
+    // compensation for rounding errors?
+    // Expected output: one at a time loses precision as the latitudes grow, to a relative error around 1e-5 at a million
+    // latitudes, and is slowed by a division per latitude. Pairwise and compensated both stay within a float rounding of
+    // the reference, about 1e-7, at every size, since the last rounding of an average of positive terms hides what
+    // compensation gains. On the imbalances, which nearly cancel, it shows: pairwise is off by 10 to 20% up to 10000
+    // latitudes and by several times the average at a million, while compensated stays within about 1e-8, and 0.002 at
+    // a million. Pairwise is the fastest, at around 0.2 to 0.5 ns per latitude, and compensated can't be vectorized, so
+    // it takes about 2 ns per latitude.
+    TestSummation();
+
+    std::cout << "Test 29" << std::endl;
+    // Test 29: how much faster and how much less exact is running a round world with many latitudes when its cover is
+    // stored in floats or 16 bit fixed point rather than doubles?
+    // Expected output: first, at 90 latitudes a profile in doubles stays within float rounding of the world's own float
+    // updates: about 1e-8 after one update and a few 1e-6 after 3000, with and without conduction. Then over 500
+    // updates, float storage stays within about 1e-6 of double storage at every latitude,
+    // and fixed point within about 1e-3, with the cover of the whole planet within about 1e-6 since its rounding is
+    // unbiased. Floats take one half to three quarters as long as doubles. Each update takes around 10 to 20 ns per
+    // latitude, mostly computing rather than moving memory, so fixed point is no faster than doubles once it pays for
+    // its rounding.
+    TestMixedPrecision();
+
+    std::cout << "Test 30" << std::endl;
+    // Test 30: how much do proportions decaying into subnormal floats slow down a round world where daisies die out?
+    // Expected output: without a threshold, the black daisies decay to around 1e-31, with the latitudes where they
+    // decline fastest already subnormal, and updates take about 10 times as long on average and 20 times at the
+    // slowest. Flushing subnormals to zero keeps every update around 1 us, though the daisies still linger at the same
+    // proportion. With the default threshold, they die out entirely and their latitudes are skipped, so updates are
+    // faster still.
+    TestSubnormalProtection();
+
+    std::cout << "Test 31" << std::endl;
+    // Test 31: does a round world conserve energy, and where does it move heat?
+    // Expected output: without conduction, every latitude emits at the global temperature, so the global budget
+    // balances to within float rounding, and each band's imbalance is the heat the model carries from the equator,
+    // which absorbs tens of W/m^2 more than it emits, to the pole, which emits more than it absorbs. With half of the
+    // temperature conducting from each latitude itself, less heat is carried and the bands are closer to balance, but
+    // mixing temperatures rather than emissions leaves the planet emitting around 0.1 W/m^2 less than it absorbs.
+    // Tracking the budget adds about a tenth to each update, and nothing when it is off.
+    TestEnergyBudget();
+
 };
\ No newline at end of file
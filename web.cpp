@@ -370,9 +370,7 @@ public:
 
         canvas.Clear();
         int number_of_updates = world.GetUpdatesPerTimeUnit() * world_time_per_frame;
-        for (int update = 0; update < number_of_updates; update++) {
-            world.Update();
-        }
+        world.UpdateN(number_of_updates);
 
         UpdateGrid();
         Draw();